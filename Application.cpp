@@ -26,13 +26,31 @@ void handler(int sig) {
  **********************************/
 int main(int argc, char *argv[]) {
 	//signal(SIGSEGV, handler);
-	if ( argc != ARGS_COUNT ) {
+	char *conf = NULL;
+	unsigned long seed = time(NULL);
+	for ( int i = 1; i < argc; i++ ) {
+		if ( 0 == strcmp(argv[i], "--seed") && i + 1 < argc ) {
+			seed = strtoul(argv[++i], NULL, 10);
+		}
+		else if ( conf == NULL ) {
+			conf = argv[i];
+		}
+		else {
+			conf = NULL;
+			break;
+		}
+	}
+	if ( conf == NULL ) {
+		cout<<"Usage: Application [--seed N] file.conf"<<endl;
 		cout<<"Configuration (i.e., *.conf) file File Required"<<endl;
 		return FAILURE;
 	}
 
+	// Printed so that any run can be repeated with --seed
+	cout<<"Random seed "<<seed<<endl;
+
 	// Create a new application object
-	Application *app = new Application(argv[1]);
+	Application *app = new Application(conf, seed);
 	// Call the run function
 	app->run();
 	// When done delete the application object
@@ -44,14 +62,40 @@ int main(int argc, char *argv[]) {
 /**
  * Constructor of the Application class
  */
-Application::Application(char *infile) {
+Application::Application(char *infile, unsigned long seed) {
 	int i;
 	par = new Params();
-	srand (time(NULL));
 	par->setparams(infile);
+	par->SEED = seed;
+	random.setSeed(seed, STREAM_APPLICATION);
 	log = new Log(par);
 	en = new EmulNet(par);
+	en->ENsetLog(log);
+	net = en;
+	if ( par->TRANSPORT == UDP_TRANSPORT ) {
+		UdpNet *udp = new UdpNet(par);
+		udp->ENsetLog(log);
+		net = udp;
+	}
+	else if ( par->TRANSPORT == SHM_TRANSPORT ) {
+		ShmNet *shm = new ShmNet(par);
+		shm->ENsetLog(log);
+		net = shm;
+	}
+	if ( net != en ) {
+		// the parallel and event engines rely on EmulNet's mailboxes
+		par->NUM_THREADS = 1;
+		par->EVENT_DRIVEN = 0;
+	}
 	mp1 = (MP1Node **) malloc(par->EN_GPSZ * sizeof(MP1Node *));
+	pool = NULL;
+	if ( par->NUM_THREADS > 1 ) {
+		pool = new WorkerPool(min(par->NUM_THREADS, par->EN_GPSZ));
+		en->ENsetOutboxes(pool->getPartitions());
+		log->setCaptures(pool->getPartitions());
+		introCaptures.resize(pool->getPartitions());
+		introCounts.resize(pool->getPartitions());
+	}
 
 	/*
 	 * Init all nodes
@@ -62,9 +106,9 @@ Application::Application(char *infile) {
 		Address *addressOfMemberNode = new Address();
 		Address joinaddr;
 		joinaddr = getjoinaddr();
-		addressOfMemberNode = (Address *) en->ENinit(addressOfMemberNode, par->PORTNUM);
-		mp1[i] = new MP1Node(memberNode, par, en, log, addressOfMemberNode);
-		log->LOG(&(mp1[i]->getMemberNode()->addr), "APP");
+		addressOfMemberNode = (Address *) net->ENinit(addressOfMemberNode, par->PORTNUM);
+		mp1[i] = new MP1Node(memberNode, par, net, log, addressOfMemberNode);
+		LOG_INFO(log, &(mp1[i]->getMemberNode()->addr), "APP");
 		delete addressOfMemberNode;
 	}
 }
@@ -73,7 +117,11 @@ Application::Application(char *infile) {
  * Destructor
  */
 Application::~Application() {
+	delete pool;
 	delete log;
+	if ( net != en ) {
+		delete net;
+	}
 	delete en;
 	for ( int i = 0; i < par->EN_GPSZ; i++ ) {
 		delete mp1[i];
@@ -93,18 +141,29 @@ int Application::run()
 	int timeWhenAllNodesHaveJoined = 0;
 	// boolean indicating if all nodes have joined
 	bool allNodesJoined = false;
-	srand(time(NULL));
 
+	if ( par->EVENT_DRIVEN ) {
+		runEvents();
+	}
 	// As time runs along
-	for( par->globaltime = 0; par->globaltime < TOTAL_RUNNING_TIME; ++par->globaltime ) {
+	else for( par->globaltime = 0; par->globaltime < TOTAL_RUNNING_TIME; ++par->globaltime ) {
 		// Run the membership protocol
-		mp1Run();
+		if ( pool != NULL ) {
+			mp1RunParallel();
+		}
+		else {
+			mp1Run();
+		}
+		net->ENflush();
 		// Fail some nodes
 		fail();
+		if ( par->TICK_MS > 0 ) {
+			waitTick();
+		}
 	}
 
 	// Clean up
-	en->ENcleanup();
+	net->ENcleanup();
 
 	for(i=0;i<=par->EN_GPSZ-1;i++) {
 		 mp1[i]->finishUpThisNode();
@@ -113,6 +172,31 @@ int Application::run()
 	return SUCCESS;
 }
 
+/**
+ * FUNCTION NAME: waitTick
+ *
+ * DESCRIPTION: Sleep out the rest of the tick when ticks last TICK_MS of real time, so
+ * 				that processes sharing a transport keep pace. Messages arriving
+ * 				meanwhile are taken in as they come.
+ */
+void Application::waitTick() {
+	chrono::steady_clock::time_point now = chrono::steady_clock::now();
+	if ( par->getcurrtime() == 0 ) {
+		tickEnd = now;
+	}
+	tickEnd += chrono::milliseconds(par->TICK_MS);
+
+	while ( now < tickEnd ) {
+		int ms = chrono::duration_cast<chrono::milliseconds>(tickEnd - now).count() + 1;
+		if ( net->ENwait(ms) ) {
+			for ( int i = 0; i < par->EN_GPSZ; i++ ) {
+				recvNode(i);
+			}
+		}
+		now = chrono::steady_clock::now();
+	}
+}
+
 /**
  * FUNCTION NAME: mp1Run
  *
@@ -123,44 +207,204 @@ void Application::mp1Run() {
 
 	// For all the nodes in the system
 	for( i = 0; i <= par->EN_GPSZ-1; i++) {
-
-		/*
-		 * Receive messages from the network and queue them in the membership protocol queue
-		 */
-		if( par->getcurrtime() > (int)(par->STEP_RATE*i) && !(mp1[i]->getMemberNode()->bFailed) ) {
-			// Receive messages from the network and queue them
-			mp1[i]->recvLoop();
-		}
-
+		recvNode(i);
 	}
 
 	// For all the nodes in the system
 	for( i = par->EN_GPSZ - 1; i >= 0; i-- ) {
+		nodeCount += runNode(i, NULL);
+	}
+}
+
+/**
+ * FUNCTION NAME: recvNode
+ *
+ * DESCRIPTION: Receive messages of the ith node from the network and queue them in the
+ * 				membership protocol queue
+ */
+void Application::recvNode(int i) {
+	if( par->getcurrtime() > (int)(par->STEP_RATE*i) && !(mp1[i]->getMemberNode()->bFailed) ) {
+		// Receive messages from the network and queue them
+		mp1[i]->recvLoop();
+	}
+}
 
-		/*
-		 * Introduce nodes into the distributed system
-		 */
-		if( par->getcurrtime() == (int)(par->STEP_RATE*i) ) {
-			// introduce the ith node into the system at time STEPRATE*i
-			mp1[i]->nodeStart(JOINADDR, par->PORTNUM);
+/**
+ * FUNCTION NAME: runNode
+ *
+ * DESCRIPTION: Introduce the ith node into the system at time STEP_RATE*i, afterwards handle
+ * 				its messages and send heartbeats. The introduction notice is appended to
+ * 				intro, or printed when intro is NULL.
+ *
+ * RETURNS:
+ * i if the node was introduced, 0 otherwise
+ */
+int Application::runNode(int i, string *intro) {
+	/*
+	 * Introduce nodes into the distributed system
+	 */
+	if( par->getcurrtime() == (int)(par->STEP_RATE*i) ) {
+		// introduce the ith node into the system at time STEPRATE*i
+		mp1[i]->nodeStart(JOINADDR, par->PORTNUM);
+		if ( intro != NULL ) {
+			*intro += to_string(i) + "-th introduced node is assigned with the address: " + mp1[i]->getMemberNode()->addr.getAddress() + "\n";
+		}
+		else {
 			cout<<i<<"-th introduced node is assigned with the address: "<<mp1[i]->getMemberNode()->addr.getAddress() << endl;
-			nodeCount += i;
 		}
+		return i;
+	}
 
-		/*
-		 * Handle all the messages in your queue and send heartbeats
-		 */
-		else if( par->getcurrtime() > (int)(par->STEP_RATE*i) && !(mp1[i]->getMemberNode()->bFailed) ) {
-			// handle messages and send heartbeats
-			mp1[i]->nodeLoop();
-			#ifdef DEBUGLOG
-			if( (i == 0) && (par->globaltime % 500 == 0) ) {
-				log->LOG(&mp1[i]->getMemberNode()->addr, "@@time=%d", par->getcurrtime());
+	/*
+	 * Handle all the messages in your queue and send heartbeats
+	 */
+	else if( par->getcurrtime() > (int)(par->STEP_RATE*i) && !(mp1[i]->getMemberNode()->bFailed) ) {
+		// handle messages and send heartbeats
+		mp1[i]->nodeLoop();
+		if( (i == 0) && (par->globaltime % 500 == 0) ) {
+			LOG_DEBUG(log, &mp1[i]->getMemberNode()->addr, "@@time=%d", par->getcurrtime());
+		}
+	}
+	return 0;
+}
+
+/**
+ * FUNCTION NAME: mp1RunParallel
+ *
+ * DESCRIPTION: Same as mp1Run, with the nodes split into partitions run by the worker pool.
+ * 				Sends and log lines are buffered per partition and released after the
+ * 				barrier in the order a serial run would have produced them.
+ */
+void Application::mp1RunParallel() {
+	pool->run([this](int partition) { mp1RunPartition(partition); });
+
+	en->ENflushOutboxes();
+	log->flushCaptures();
+	for ( size_t p = 0; p < introCaptures.size(); p++ ) {
+		cout << introCaptures[p];
+		introCaptures[p].clear();
+		nodeCount += introCounts[p];
+		introCounts[p] = 0;
+	}
+}
+
+/**
+ * FUNCTION NAME: mp1RunPartition
+ *
+ * DESCRIPTION: One tick of the nodes of a partition. Partition 0 holds the highest
+ * 				indexes, so concatenating partitions in order walks the nodes downwards
+ * 				like the second loop of mp1Run.
+ */
+void Application::mp1RunPartition(int partition) {
+	int i;
+	int partitions = pool->getPartitions();
+	int chunk = (par->EN_GPSZ + partitions - 1) / partitions;
+	int hi = par->EN_GPSZ - 1 - partition * chunk;
+	int lo = max(hi - chunk + 1, 0);
+
+	en->ENcapture(partition);
+	log->startCapture(partition, true);
+
+	for( i = lo; i <= hi; i++ ) {
+		recvNode(i);
+	}
+
+	log->startCapture(partition);
+
+	for( i = hi; i >= lo; i-- ) {
+		introCounts[partition] += runNode(i, &introCaptures[partition]);
+	}
+
+	en->ENcapture(-1);
+	log->startCapture(-1);
+}
+
+/**
+ * FUNCTION NAME: runEvents
+ *
+ * DESCRIPTION: Discrete-event alternative to the tick loop of run. A node is only called
+ * 				at ticks where it starts, has a message waiting or is in the group and
+ * 				owes its heartbeat; ticks without any event are skipped. Events of a tick
+ * 				run in the order of the tick loop, so both produce the same run.
+ */
+void Application::runEvents() {
+	int i;
+	SimEvent ev;
+
+	wokenAt.assign(par->EN_GPSZ, -1);
+	for( i = 0; i < par->EN_GPSZ; i++ ) {
+		wake(i, (int)(par->STEP_RATE*i));
+	}
+	int failTimes[] = { DROP_START_TIME, FAIL_TIME, DROP_STOP_TIME };
+	for( i = 0; i < 3; i++ ) {
+		ev.time = failTimes[i];
+		ev.phase = FAIL_EVENT;
+		ev.order = 0;
+		ev.node = -1;
+		events.push(ev);
+	}
+	en->ENsetDeliveryHook(deliveryHook, this);
+
+	while( !events.empty() && events.top().time < TOTAL_RUNNING_TIME ) {
+		ev = events.top();
+		events.pop();
+		par->globaltime = ev.time;
+
+		switch( ev.phase ) {
+			case RECV_EVENT:
+				recvNode(ev.node);
+				break;
+			case NODE_EVENT: {
+				nodeCount += runNode(ev.node, NULL);
+				Member *node = mp1[ev.node]->getMemberNode();
+				// still has work next tick: heartbeats, or messages sent before it started
+				if( node->inited && !node->bFailed && (node->inGroup || en->ENpending(&node->addr) > 0) ) {
+					wake(ev.node, ev.time + 1);
+				}
+				break;
 			}
-			#endif
+			case FAIL_EVENT:
+				fail();
+				break;
 		}
+	}
 
+	en->ENsetDeliveryHook(NULL, NULL);
+	par->globaltime = TOTAL_RUNNING_TIME;
+}
+
+/**
+ * FUNCTION NAME: wake
+ *
+ * DESCRIPTION: Schedule the receive and process events of the ith node at time
+ */
+void Application::wake(int i, int time) {
+	if ( i < 0 || i >= par->EN_GPSZ || wokenAt[i] >= time ) {
+		return;
 	}
+	wokenAt[i] = time;
+
+	SimEvent ev;
+	ev.time = time;
+	ev.node = i;
+	ev.phase = RECV_EVENT;
+	ev.order = i;
+	events.push(ev);
+	ev.phase = NODE_EVENT;
+	ev.order = par->EN_GPSZ - 1 - i;
+	events.push(ev);
+}
+
+/**
+ * FUNCTION NAME: deliveryHook
+ *
+ * DESCRIPTION: Called by EmulNet for every message put in a mailbox, wakes up its receiver
+ * 				on the next tick
+ */
+void Application::deliveryHook(void *env, int id) {
+	Application *app = (Application *)env;
+	// node ids are handed out by ENinit in node order, starting at 1
+	app->wake(id - 1, app->par->getcurrtime() + 1);
 }
 
 /**
@@ -174,28 +418,26 @@ void Application::fail() {
 	int i, removed;
 
 	// fail half the members at time t=400
-	if( par->DROP_MSG && par->getcurrtime() == 50 ) {
+	if( par->DROP_MSG && par->getcurrtime() == DROP_START_TIME ) {
 		par->dropmsg = 1;
 	}
 
-	if( par->SINGLE_FAILURE && par->getcurrtime() == 100 ) {
-		removed = (rand() % par->EN_GPSZ);
-		#ifdef DEBUGLOG
-		log->LOG(&mp1[removed]->getMemberNode()->addr, "Node failed at time=%d", par->getcurrtime());
-		#endif
+	if( par->SINGLE_FAILURE && par->getcurrtime() == FAIL_TIME ) {
+		removed = random.below(par->EN_GPSZ);
+		LOG_EVENT(log, &mp1[removed]->getMemberNode()->addr, "Node failed at time=%d", par->getcurrtime());
+		log->logEvent(EV_FAIL, &mp1[removed]->getMemberNode()->addr, &mp1[removed]->getMemberNode()->addr, 0);
 		mp1[removed]->getMemberNode()->bFailed = true;
 	}
-	else if( par->getcurrtime() == 100 ) {
-		removed = rand() % par->EN_GPSZ/2;
+	else if( par->getcurrtime() == FAIL_TIME ) {
+		removed = random.below(par->EN_GPSZ) / 2;
 		for ( i = removed; i < removed + par->EN_GPSZ/2; i++ ) {
-			#ifdef DEBUGLOG
-			log->LOG(&mp1[i]->getMemberNode()->addr, "Node failed at time = %d", par->getcurrtime());
-			#endif
+			LOG_EVENT(log, &mp1[i]->getMemberNode()->addr, "Node failed at time = %d", par->getcurrtime());
+			log->logEvent(EV_GROUP_FAIL, &mp1[i]->getMemberNode()->addr, &mp1[i]->getMemberNode()->addr, 0);
 			mp1[i]->getMemberNode()->bFailed = true;
 		}
 	}
 
-	if( par->DROP_MSG && par->getcurrtime() == 300) {
+	if( par->DROP_MSG && par->getcurrtime() == DROP_STOP_TIME) {
 		par->dropmsg=0;
 	}
 
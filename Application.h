@@ -7,13 +7,18 @@
 #ifndef _APPLICATION_H_
 #define _APPLICATION_H_
 
+#include <chrono>
 #include "stdincludes.h"
 #include "MP1Node.h"
 #include "Log.h"
 #include "Params.h"
 #include "Member.h"
 #include "EmulNet.h"
+#include "UdpNet.h"
+#include "ShmNet.h"
 #include "Queue.h"
+#include "WorkerPool.h"
+#include "Random.h"
 
 /**
  * global variables
@@ -23,8 +28,46 @@ int nodeCount = 0;
 /*
  * Macros
  */
-#define ARGS_COUNT 2
 #define TOTAL_RUNNING_TIME 700
+// Times at which fail() changes the system
+#define DROP_START_TIME 50
+#define FAIL_TIME 100
+#define DROP_STOP_TIME 300
+
+/**
+ * Event phases, in the order they run within a tick
+ */
+enum EventTypes {
+	RECV_EVENT,
+	NODE_EVENT,
+	FAIL_EVENT
+};
+
+/**
+ * STRUCT NAME: SimEvent
+ *
+ * DESCRIPTION: Event of the discrete-event scheduler
+ */
+typedef struct SimEvent {
+	int time;
+	enum EventTypes phase;
+	// position of the event within its phase
+	int order;
+	int node;
+}SimEvent;
+
+/**
+ * STRUCT NAME: SimEventLater
+ *
+ * DESCRIPTION: Orders the event queue so that the earliest event is on top
+ */
+struct SimEventLater {
+	bool operator()(const SimEvent &a, const SimEvent &b) const {
+		if ( a.time != b.time ) return a.time > b.time;
+		if ( a.phase != b.phase ) return a.phase > b.phase;
+		return a.order > b.order;
+	}
+};
 
 /**
  * CLASS NAME: Application
@@ -37,15 +80,36 @@ private:
 	// Coordinator Node
 	char JOINADDR[30];
 	EmulNet *en;
+	// Network the nodes use: en, or a real one
+	Transport *net;
     Log *log;
 	MP1Node **mp1;
 	Params *par;
+	// Choice of the nodes to fail
+	Random random;
+	// Parallel engine, NULL when running serially
+	WorkerPool *pool;
+	vector<string> introCaptures;
+	vector<int> introCounts;
+	void mp1RunPartition(int partition);
+	// Discrete-event scheduler
+	priority_queue<SimEvent, vector<SimEvent>, SimEventLater> events;
+	vector<int> wokenAt;
+	void runEvents();
+	void wake(int i, int time);
+	static void deliveryHook(void *env, int id);
+	// Real-time end of the current tick when TICK_MS is set
+	chrono::steady_clock::time_point tickEnd;
+	void waitTick();
+	void recvNode(int i);
+	int runNode(int i, string *intro);
 public:
-	Application(char *);
+	Application(char *, unsigned long seed);
 	virtual ~Application();
 	Address getjoinaddr();
 	int run();
 	void mp1Run();
+	void mp1RunParallel();
 	void fail();
 };
 
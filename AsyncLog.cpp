@@ -0,0 +1,159 @@
+/**********************************
+ * FILE NAME: AsyncLog.cpp
+ *
+ * DESCRIPTION: Definition of the asynchronous log writer
+ **********************************/
+
+#include <chrono>
+#include "AsyncLog.h"
+
+/**
+ * Constructor
+ */
+AsyncLog::AsyncLog(FILE *dbg, FILE *stats, size_t flushBytes, int flushMs):
+	dbg(dbg), stats(stats), flushBytes(flushBytes), flushMs(flushMs), head(0), tail(0), stopping(false), sleeping(false) {
+	ring = new LogRecord[LOG_RING_SIZE];
+	for ( size_t i = 0; i < LOG_RING_SIZE; i++ ) {
+		ring[i].seq.store(i, memory_order_relaxed);
+	}
+	writer = thread(&AsyncLog::run, this);
+}
+
+/**
+ * Destructor. Writes out everything pushed so far.
+ */
+AsyncLog::~AsyncLog() {
+	stopping.store(true);
+	{
+		lock_guard<mutex> guard(lock);
+		wakeup.notify_one();
+	}
+	writer.join();
+	delete[] ring;
+}
+
+/**
+ * FUNCTION NAME: push
+ *
+ * DESCRIPTION: Queue len bytes of text for dbg.log, or stats.log when toStats is set.
+ * 				Waits for room when the ring is full.
+ */
+void AsyncLog::push(bool toStats, const char *text, int len) {
+	LogRecord *record;
+	size_t pos = head.load(memory_order_relaxed);
+
+	while ( true ) {
+		record = &ring[pos & (LOG_RING_SIZE - 1)];
+		size_t seq = record->seq.load(memory_order_acquire);
+		if ( seq == pos ) {
+			if ( head.compare_exchange_weak(pos, pos + 1, memory_order_relaxed) ) {
+				break;
+			}
+		}
+		else if ( seq < pos ) {
+			// full: the writer has not freed this slot yet
+			this_thread::yield();
+			pos = head.load(memory_order_relaxed);
+		}
+		else {
+			pos = head.load(memory_order_relaxed);
+		}
+	}
+
+	record->stats = toStats;
+	record->len = len;
+	if ( len <= LOG_RECORD_SIZE ) {
+		record->heap = NULL;
+		memcpy(record->text, text, len);
+	}
+	else {
+		record->heap = (char *)malloc(len);
+		memcpy(record->heap, text, len);
+	}
+	record->seq.store(pos + 1, memory_order_release);
+
+	atomic_thread_fence(memory_order_seq_cst);
+	if ( sleeping.load(memory_order_relaxed) ) {
+		lock_guard<mutex> guard(lock);
+		wakeup.notify_one();
+	}
+}
+
+/**
+ * FUNCTION NAME: writeOne
+ *
+ * DESCRIPTION: Write the oldest pushed record if there is one
+ *
+ * RETURNS:
+ * number of bytes written, -1 if the ring is empty
+ */
+int AsyncLog::writeOne() {
+	LogRecord *record = &ring[tail & (LOG_RING_SIZE - 1)];
+	if ( record->seq.load(memory_order_acquire) != tail + 1 ) {
+		return -1;
+	}
+	int len = record->len;
+
+	FILE *file = record->stats ? stats : dbg;
+	if ( record->heap != NULL ) {
+		fwrite(record->heap, 1, record->len, file);
+		free(record->heap);
+	}
+	else {
+		fwrite(record->text, 1, record->len, file);
+	}
+
+	record->seq.store(tail + LOG_RING_SIZE, memory_order_release);
+	tail++;
+	return len;
+}
+
+/**
+ * FUNCTION NAME: run
+ *
+ * DESCRIPTION: Body of the writer thread
+ */
+void AsyncLog::run() {
+	size_t unflushed = 0;
+	chrono::steady_clock::time_point oldest;
+
+	while ( true ) {
+		// write a batch
+		int written = 0;
+		int len;
+		while ( written < LOG_RING_SIZE && (len = writeOne()) >= 0 ) {
+			if ( unflushed == 0 ) {
+				oldest = chrono::steady_clock::now();
+			}
+			unflushed += len;
+			written++;
+		}
+
+		bool due = unflushed > 0 && (unflushed >= flushBytes
+			|| chrono::steady_clock::now() - oldest >= chrono::milliseconds(flushMs));
+		if ( due ) {
+			fflush(dbg);
+			fflush(stats);
+			unflushed = 0;
+		}
+
+		if ( written > 0 ) {
+			continue;
+		}
+		if ( stopping.load() ) {
+			// pick up whatever was pushed after the empty check above
+			while ( writeOne() >= 0 );
+			break;
+		}
+
+		unique_lock<mutex> guard(lock);
+		sleeping.store(true);
+		if ( !stopping.load() && ring[tail & (LOG_RING_SIZE - 1)].seq.load(memory_order_acquire) != tail + 1 ) {
+			wakeup.wait_for(guard, chrono::milliseconds(unflushed > 0 ? flushMs : 1000));
+		}
+		sleeping.store(false);
+	}
+
+	fflush(dbg);
+	fflush(stats);
+}
@@ -0,0 +1,68 @@
+/**********************************
+ * FILE NAME: AsyncLog.h
+ *
+ * DESCRIPTION: Header file of the asynchronous log writer
+ **********************************/
+
+#ifndef _ASYNCLOG_H_
+#define _ASYNCLOG_H_
+
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "stdincludes.h"
+
+/*
+ * Macros
+ */
+// Number of records in the ring, a power of two
+#define LOG_RING_SIZE 4096
+// Text stored inline in a record, longer lines are copied to the heap
+#define LOG_RECORD_SIZE 240
+
+/**
+ * STRUCT NAME: LogRecord
+ *
+ * DESCRIPTION: Slot of the ring. seq tells producers and the consumer whose turn it is.
+ */
+typedef struct LogRecord {
+	atomic<size_t> seq;
+	bool stats;
+	int len;
+	char *heap;
+	char text[LOG_RECORD_SIZE];
+}LogRecord;
+
+/**
+ * CLASS NAME: AsyncLog
+ *
+ * DESCRIPTION: Lines pushed by any thread go into a bounded lock-free ring; a background
+ * 				thread writes them to dbg.log or stats.log in push order. Files are flushed
+ * 				once flushBytes were written or the oldest unflushed line is flushMs old.
+ */
+class AsyncLog {
+private:
+	FILE *dbg;
+	FILE *stats;
+	size_t flushBytes;
+	int flushMs;
+	LogRecord *ring;
+	// next slot to claim by producers
+	atomic<size_t> head;
+	// next slot to write, only touched by the writer thread
+	size_t tail;
+	atomic<bool> stopping;
+	atomic<bool> sleeping;
+	mutex lock;
+	condition_variable wakeup;
+	thread writer;
+	void run();
+	int writeOne();
+public:
+	AsyncLog(FILE *dbg, FILE *stats, size_t flushBytes, int flushMs);
+	virtual ~AsyncLog();
+	void push(bool toStats, const char *text, int len);
+};
+
+#endif /* _ASYNCLOG_H_ */
@@ -5,40 +5,37 @@
  **********************************/
 
 #include "EmulNet.h"
+#include "MsgPool.h"
+
+thread_local int EmulNet::outbox = -1;
 
 /**
  * Constructor
  */
-EmulNet::EmulNet(Params *p)
+EmulNet::EmulNet(Params *p): stats(p->EN_GPSZ)
 {
 	//trace.funcEntry("EmulNet::EmulNet");
-	int i,j;
 	par = p;
+	deliveryHook = NULL;
+	deliveryEnv = NULL;
+	log = NULL;
+	random.setSeed(p->SEED, STREAM_NETWORK);
 	emulnet.setNextId(1);
 	emulnet.settCurrBuffSize(0);
 	enInited=0;
-	for ( i = 0; i < MAX_NODES; i++ ) {
-		for ( j = 0; j < MAX_TIME; j++ ) {
-			sent_msgs[i][j] = 0;
-			recv_msgs[i][j] = 0;
-		}
-	}
 	//trace.funcExit("EmulNet::EmulNet", SUCCESS);
 }
 
 /**
  * Copy constructor
  */
-EmulNet::EmulNet(EmulNet &anotherEmulNet) {
-	int i, j;
+EmulNet::EmulNet(EmulNet &anotherEmulNet): stats(anotherEmulNet.stats) {
 	this->par = anotherEmulNet.par;
 	this->enInited = anotherEmulNet.enInited;
-	for ( i = 0; i < MAX_NODES; i++ ) {
-		for ( j = 0; j < MAX_TIME; j++ ) {
-			this->sent_msgs[i][j] = anotherEmulNet.sent_msgs[i][j];
-			this->recv_msgs[i][j] = anotherEmulNet.recv_msgs[i][j];
-		}
-	}
+	this->deliveryHook = anotherEmulNet.deliveryHook;
+	this->deliveryEnv = anotherEmulNet.deliveryEnv;
+	this->log = anotherEmulNet.log;
+	this->random = anotherEmulNet.random;
 	this->emulnet = anotherEmulNet.emulnet;
 }
 
@@ -46,15 +43,13 @@ EmulNet::EmulNet(EmulNet &anotherEmulNet) {
  * Assignment operator overloading
  */
 EmulNet& EmulNet::operator =(EmulNet &anotherEmulNet) {
-	int i, j;
+	this->stats = anotherEmulNet.stats;
 	this->par = anotherEmulNet.par;
 	this->enInited = anotherEmulNet.enInited;
-	for ( i = 0; i < MAX_NODES; i++ ) {
-		for ( j = 0; j < MAX_TIME; j++ ) {
-			this->sent_msgs[i][j] = anotherEmulNet.sent_msgs[i][j];
-			this->recv_msgs[i][j] = anotherEmulNet.recv_msgs[i][j];
-		}
-	}
+	this->deliveryHook = anotherEmulNet.deliveryHook;
+	this->deliveryEnv = anotherEmulNet.deliveryEnv;
+	this->log = anotherEmulNet.log;
+	this->random = anotherEmulNet.random;
 	this->emulnet = anotherEmulNet.emulnet;
 	return *this;
 }
@@ -73,107 +68,245 @@ void *EmulNet::ENinit(Address *myaddr, short port) {
 	// Initialize data structures for this member
 	*(int *)(myaddr->addr) = emulnet.nextid++;
     *(short *)(&myaddr->addr[4]) = 0;
+	emulnet.getMailbox(*(int *)(myaddr->addr));
+	stats.addNode(*(int *)(myaddr->addr));
 	return myaddr;
 }
 
 /**
  * FUNCTION NAME: ENsend
  *
- * DESCRIPTION: EmulNet send function
+ * DESCRIPTION: EmulNet send function. The payload is not copied, the message
+ * 				takes its own reference to it.
  *
  * RETURNS:
  * size
  */
-int EmulNet::ENsend(Address *myaddr, Address *toaddr, char *data, int size) {
-	en_msg *em;
-	static char temp[2048];
-	int sendmsg = rand() % 100;
-
-	if( (emulnet.currbuffsize >= ENBUFFSIZE) || (size + (int)sizeof(en_msg) >= par->MAX_MSG_SIZE) || (par->dropmsg && sendmsg < (int) (par->MSG_DROP_PROB * 100)) ) {
-		return 0;
-	}
-
-	em = (en_msg *)malloc(sizeof(en_msg) + size);
-	em->size = size;
+int EmulNet::ENsend(Address *myaddr, Address *toaddr, Payload *payload) {
+	en_msg *em = (en_msg *)MsgPool::alloc(sizeof(en_msg));
+	em->size = payload->getSize();
 
 	memcpy(&(em->from.addr), &(myaddr->addr), sizeof(em->from.addr));
 	memcpy(&(em->to.addr), &(toaddr->addr), sizeof(em->from.addr));
-	memcpy(em + 1, data, size);
+	payload->retain();
+	em->payload = payload;
+	em->record = -1;
+
+	if ( outbox >= 0 ) {
+		// parallel phase: delivered in a deterministic order by ENflushOutboxes. The
+		// send is recorded now, where a serial run records it, and the record is
+		// taken back if the message is dropped.
+		if ( log != NULL ) {
+			em->record = log->logEvent(EV_SEND, myaddr, toaddr, em->size);
+		}
+		outboxes[outbox].push_back(em);
+		return em->size;
+	}
+	return ENdeliver(em);
+}
 
-	emulnet.buff[emulnet.currbuffsize++] = em;
+/**
+ * FUNCTION NAME: ENsendMulti
+ *
+ * DESCRIPTION: Send payload to each of the count addresses in toaddrs. The drop
+ * 				decisions are made in one pass, in the order ENsend would make them, and
+ * 				the messages kept share one retain and one update of the counters.
+ *
+ * RETURNS:
+ * number of messages not dropped
+ */
+int EmulNet::ENsendMulti(Address *myaddr, Address *toaddrs, int count, Payload *payload) {
+	if ( outbox >= 0 ) {
+		// parallel phase: the decisions are made by ENflushOutboxes
+		return Transport::ENsendMulti(myaddr, toaddrs, count, payload);
+	}
 
 	int src = *(int *)(myaddr->addr);
-	int time = par->getcurrtime();
+	int size = payload->getSize();
+	bool fits = Transport::fits(size, par->MAX_MSG_SIZE);
+	int sent = 0;
 
-	assert(src <= MAX_NODES);
-	assert(time < MAX_TIME);
+	stats.addNode(src);
+	if ( !fits ) {
+		stats.countOversize(src, count);
+	}
 
-	sent_msgs[src][time]++;
+	for ( int i = 0; i < count; i++ ) {
+		int sendmsg = random.below(100);
+		int dst = *(int *)(toaddrs[i].addr);
+		if ( (dst < 0) || (emulnet.currbuffsize >= ENBUFFSIZE) || !fits || (par->dropmsg && sendmsg < (int) (par->MSG_DROP_PROB * 100)) ) {
+			continue;
+		}
 
-	#ifdef DEBUGLOG
-		sprintf(temp, "Sending 4+%d B msg type %d to %d.%d.%d.%d:%d ", size-4, *(int *)data, toaddr->addr[0], toaddr->addr[1], toaddr->addr[2], toaddr->addr[3], *(short *)&toaddr->addr[4]);
-	#endif
+		en_msg *em = (en_msg *)MsgPool::alloc(sizeof(en_msg));
+		em->size = size;
+		memcpy(&(em->from.addr), &(myaddr->addr), sizeof(em->from.addr));
+		memcpy(&(em->to.addr), &(toaddrs[i].addr), sizeof(em->to.addr));
+		em->payload = payload;
+		emulnet.getMailbox(dst).push_back(em);
+		emulnet.currbuffsize++;
+		if ( deliveryHook != NULL ) {
+			(*deliveryHook)(deliveryEnv, dst);
+		}
+		if ( log != NULL ) {
+			log->logEvent(EV_SEND, myaddr, &toaddrs[i], size);
+		}
+		sent++;
+	}
 
-	return size;
+	if ( sent > 0 ) {
+		payload->retain(sent);
+		stats.countSent(src, par->getcurrtime(), size, sent);
+	}
+	return sent;
 }
 
 /**
- * FUNCTION NAME: ENsend
+ * FUNCTION NAME: ENdeliver
  *
- * DESCRIPTION: EmulNet send function
+ * DESCRIPTION: Drop the message or put it in its destination mailbox
  *
  * RETURNS:
- * size
+ * size, 0 if dropped
  */
-int EmulNet::ENsend(Address *myaddr, Address *toaddr, string data) {
-	char * str = (char *) malloc(data.length() * sizeof(char));
-	memcpy(str, data.c_str(), data.size());
-	int ret = this->ENsend(myaddr, toaddr, str, (data.length() * sizeof(char)));
-	free(str);
-	return ret;
+int EmulNet::ENdeliver(en_msg *em) {
+	int sendmsg = random.below(100);
+	int src = *(int *)(em->from.addr);
+	int dst = *(int *)(em->to.addr);
+	int size = em->size;
+	bool fits = Transport::fits(size, par->MAX_MSG_SIZE);
+
+	stats.addNode(src);
+	if ( !fits ) {
+		stats.countOversize(src);
+	}
+	if( (dst < 0) || (emulnet.currbuffsize >= ENBUFFSIZE) || !fits || (par->dropmsg && sendmsg < (int) (par->MSG_DROP_PROB * 100)) ) {
+		if ( em->record >= 0 ) {
+			log->cancelEvent(em->record);
+		}
+		em->payload->release();
+		MsgPool::release(em);
+		return 0;
+	}
+
+	emulnet.getMailbox(dst).push_back(em);
+	emulnet.currbuffsize++;
+	if ( deliveryHook != NULL ) {
+		(*deliveryHook)(deliveryEnv, dst);
+	}
+
+	stats.countSent(src, par->getcurrtime(), size);
+	if ( log != NULL && em->record < 0 ) {
+		log->logEvent(EV_SEND, &em->from, &em->to, size);
+	}
+
+	return size;
 }
 
 /**
  * FUNCTION NAME: ENrecv
  *
- * DESCRIPTION: EmulNet receive function
+ * DESCRIPTION: EmulNet receive function. The payload is handed over without copying
+ * 				along with the message's reference to it: the receiver releases it with
+ * 				Payload::fromData(buffer)->release() once the message is handled.
  *
  * RETURN:
  * 0
  */
 int EmulNet::ENrecv(Address *myaddr, int (* enq)(void *, char *, int), struct timeval *t, int times, void *queue){
 	// times is always assumed to be 1
-	int i;
-	char* tmp;
 	int sz;
 	en_msg *emsg;
+	int dst = *(int *)(myaddr->addr);
 
-	for( i = emulnet.currbuffsize - 1; i >= 0; i-- ) {
-		emsg = emulnet.buff[i];
+	if ( dst < 0 || dst >= (int)emulnet.mailbox.size() ) {
+		return 0;
+	}
 
-		if ( 0 == strcmp(emsg->to.addr, myaddr->addr) ) {
-			sz = emsg->size;
-			tmp = (char *) malloc(sz * sizeof(char));
-			memcpy(tmp, (char *)(emsg+1), sz);
+	// Only this node's messages are touched, in the order they were sent
+	vector<en_msg*> &box = emulnet.mailbox[dst];
+	for( size_t i = 0; i < box.size(); i++ ) {
+		emsg = box[i];
 
-			emulnet.buff[i] = emulnet.buff[emulnet.currbuffsize-1];
-			emulnet.currbuffsize--;
+		sz = emsg->size;
+		if ( log != NULL ) {
+			log->logEvent(EV_RECV, myaddr, &emsg->from, sz);
+		}
+		(*enq)(queue, emsg->payload->getData(), sz);
+		MsgPool::release(emsg);
 
-			(*enq)(queue, (char *)tmp, sz);
+		stats.countRecv(dst, par->getcurrtime(), sz);
+	}
+	emulnet.currbuffsize -= box.size();
+	box.clear();
 
-			free(emsg);
+	return 0;
+}
 
-			int dst = *(int *)(myaddr->addr);
-			int time = par->getcurrtime();
+/**
+ * FUNCTION NAME: ENsetOutboxes
+ *
+ * DESCRIPTION: Create one outbox per partition of the parallel engine
+ */
+void EmulNet::ENsetOutboxes(int count) {
+	outboxes.resize(count);
+}
 
-			assert(dst <= MAX_NODES);
-			assert(time < MAX_TIME);
+/**
+ * FUNCTION NAME: ENcapture
+ *
+ * DESCRIPTION: Make sends from the calling thread go to the given outbox, or be
+ * 				delivered right away when it is -1
+ */
+void EmulNet::ENcapture(int outbox) {
+	EmulNet::outbox = outbox;
+}
 
-			recv_msgs[dst][time]++;
+/**
+ * FUNCTION NAME: ENflushOutboxes
+ *
+ * DESCRIPTION: Deliver the outboxes in partition order. Called between parallel phases,
+ * 				it applies drops in the same order as a serial run would.
+ */
+void EmulNet::ENflushOutboxes() {
+	for ( size_t i = 0; i < outboxes.size(); i++ ) {
+		for ( size_t j = 0; j < outboxes[i].size(); j++ ) {
+			ENdeliver(outboxes[i][j]);
 		}
+		outboxes[i].clear();
 	}
+}
 
-	return 0;
+/**
+ * FUNCTION NAME: ENsetDeliveryHook
+ *
+ * DESCRIPTION: Have hook called with the destination id of every message put in a mailbox
+ */
+void EmulNet::ENsetDeliveryHook(void (*hook)(void *, int), void *env) {
+	deliveryHook = hook;
+	deliveryEnv = env;
+}
+
+/**
+ * FUNCTION NAME: ENsetLog
+ *
+ * DESCRIPTION: Record sends and receives in the event log of log
+ */
+void EmulNet::ENsetLog(Log *log) {
+	this->log = log;
+}
+
+/**
+ * FUNCTION NAME: ENpending
+ *
+ * DESCRIPTION: Number of messages waiting in the mailbox of myaddr
+ */
+int EmulNet::ENpending(Address *myaddr) {
+	int dst = *(int *)(myaddr->addr);
+	if ( dst < 0 || dst >= (int)emulnet.mailbox.size() ) {
+		return 0;
+	}
+	return emulnet.mailbox[dst].size();
 }
 
 /**
@@ -183,37 +316,19 @@ int EmulNet::ENrecv(Address *myaddr, int (* enq)(void *, char *, int), struct ti
  */
 int EmulNet::ENcleanup() {
 	emulnet.nextid=0;
-	int i, j;
-	int sent_total, recv_total;
 
 	FILE* file = fopen("msgcount.log", "w+");
 
-	while(emulnet.currbuffsize > 0) {
-		free(emulnet.buff[--emulnet.currbuffsize]);
-	}
-
-	for ( i = 1; i <= par->EN_GPSZ; i++ ) {
-		fprintf(file, "node %3d ", i);
-		sent_total = 0;
-		recv_total = 0;
-
-		for (j = 0; j < par->getcurrtime(); j++) {
-
-			sent_total += sent_msgs[i][j];
-			recv_total += recv_msgs[i][j];
-			if (i != 67) {
-				fprintf(file, " (%4d, %4d)", sent_msgs[i][j], recv_msgs[i][j]);
-				if (j % 10 == 9) {
-					fprintf(file, "\n         ");
-				}
-			}
-			else {
-				fprintf(file, "special %4d %4d %4d\n", j, sent_msgs[i][j], recv_msgs[i][j]);
-			}
+	for ( size_t k = 0; k < emulnet.mailbox.size(); k++ ) {
+		for ( size_t m = 0; m < emulnet.mailbox[k].size(); m++ ) {
+			emulnet.mailbox[k][m]->payload->release();
+			MsgPool::release(emulnet.mailbox[k][m]);
 		}
-		fprintf(file, "\n");
-		fprintf(file, "node %3d sent_total %6u  recv_total %6u\n\n", i, sent_total, recv_total);
+		emulnet.mailbox[k].clear();
 	}
+	emulnet.currbuffsize = 0;
+
+	stats.write(file, par->EN_GPSZ, par->getcurrtime());
 
 	fclose(file);
 	return 0;
@@ -7,13 +7,17 @@
 #ifndef _EMULNET_H_
 #define _EMULNET_H_
 
-#define MAX_NODES 1000
-#define MAX_TIME 3600
 #define ENBUFFSIZE 30000
 
+#include <atomic>
 #include "stdincludes.h"
 #include "Params.h"
 #include "Member.h"
+#include "Payload.h"
+#include "NetStats.h"
+#include "Log.h"
+#include "Random.h"
+#include "Transport.h"
 
 using namespace std;
 
@@ -21,33 +25,36 @@ using namespace std;
  * Struct Name: en_msg
  */
 typedef struct en_msg {
-	// Number of bytes after the class
+	// Number of bytes in the payload
 	int size;
 	// Source node
 	Address from;
 	// Destination node
 	Address to;
+	// Message body, shared with every other message sending the same bytes
+	Payload *payload;
+	// Event log record of a send made during a parallel phase, -1 if none
+	int64_t record;
 }en_msg;
 
 /**
  * Class Name: EM
+ *
+ * Description: Messages in flight, kept in one mailbox per destination node id
  */
 class EM {
 public:
 	int nextid;
-	int currbuffsize;
+	// updated by concurrent receivers in the parallel engine
+	atomic<int> currbuffsize;
 	int firsteltindex;
-	en_msg* buff[ENBUFFSIZE];
+	vector< vector<en_msg*> > mailbox;
 	EM() {}
 	EM& operator = (EM &anotherEM) {
 		this->nextid = anotherEM.getNextId();
 		this->currbuffsize = anotherEM.getCurrBuffSize();
 		this->firsteltindex = anotherEM.getFirstEltIndex();
-		int i = this->currbuffsize;
-		while (i > 0) {
-			this->buff[i] = anotherEM.buff[i];
-			i--;
-		}
+		this->mailbox = anotherEM.mailbox;
 		return *this;
 	}
 	int getNextId() {
@@ -68,6 +75,15 @@ public:
 	void setFirstEltIndex(int firsteltindex) {
 		this->firsteltindex = firsteltindex;
 	}
+	/**
+	 * Mailbox of the node with the given id, grown on demand
+	 */
+	vector<en_msg*> &getMailbox(int id) {
+		if ( id >= (int)mailbox.size() ) {
+			mailbox.resize(id + 1);
+		}
+		return mailbox[id];
+	}
 	virtual ~EM() {}
 };
 
@@ -76,23 +92,41 @@ public:
  *
  * DESCRIPTION: This class defines an emulated network
  */
-class EmulNet
+class EmulNet: public Transport
 { 	
 private:
 	Params* par;
-	int sent_msgs[MAX_NODES + 1][MAX_TIME];
-	int recv_msgs[MAX_NODES + 1][MAX_TIME];
+	NetStats stats;
 	int enInited;
 	EM emulnet;
+	// Messages sent during a parallel phase, one outbox per partition
+	vector< vector<en_msg*> > outboxes;
+	// Outbox the calling thread sends into, -1 to deliver right away
+	static thread_local int outbox;
+	// Called with the destination id of every message put in a mailbox
+	void (*deliveryHook)(void *env, int id);
+	void *deliveryEnv;
+	// Records sends and receives in the event log
+	Log *log;
+	// Drop decisions, made in delivery order
+	Random random;
+	int ENdeliver(en_msg *em);
 public:
  	EmulNet(Params *p);
  	EmulNet(EmulNet &anotherEmulNet);
  	EmulNet& operator = (EmulNet &anotherEmulNet);
  	virtual ~EmulNet();
 	void *ENinit(Address *myaddr, short port);
-	int ENsend(Address *myaddr, Address *toaddr, string data);
-	int ENsend(Address *myaddr, Address *toaddr, char *data, int size);
+	using Transport::ENsend;
+	int ENsend(Address *myaddr, Address *toaddr, Payload *payload);
+	int ENsendMulti(Address *myaddr, Address *toaddrs, int count, Payload *payload);
 	int ENrecv(Address *myaddr, int (* enq)(void *, char *, int), struct timeval *t, int times, void *queue);
+	void ENsetOutboxes(int count);
+	void ENcapture(int outbox);
+	void ENflushOutboxes();
+	void ENsetDeliveryHook(void (*hook)(void *, int), void *env);
+	void ENsetLog(Log *log);
+	int ENpending(Address *myaddr);
 	int ENcleanup();
 };
 
@@ -0,0 +1,125 @@
+/**********************************
+ * FILE NAME: EventConvert.cpp
+ *
+ * DESCRIPTION: Converts the binary event log to the text format of dbg.log
+ **********************************/
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "EventLog.h"
+#include "Log.h"
+
+/**
+ * FUNCTION NAME: formatAddr
+ *
+ * DESCRIPTION: Print addr the way Log does
+ */
+static void formatAddr(char *out, const char *addr) {
+	sprintf(out, "%d.%d.%d.%d:%d", addr[0], addr[1], addr[2], addr[3], *(short *)&addr[4]);
+}
+
+/**********************************
+ * FUNCTION NAME: main
+ *
+ * DESCRIPTION: Usage: EventConvert [-a] [events.bin [dbg.log]]
+ * 				Membership events are written as the lines Log writes for them;
+ * 				-a also writes a line per message sent or received.
+ **********************************/
+int main(int argc, char *argv[]) {
+	bool all = false;
+	const char *in = EVENT_LOG_FILE;
+	const char *out = NULL;
+	int arg = 1;
+
+	if ( arg < argc && 0 == strcmp(argv[arg], "-a") ) {
+		all = true;
+		arg++;
+	}
+	if ( arg < argc ) {
+		in = argv[arg++];
+	}
+	if ( arg < argc ) {
+		out = argv[arg++];
+	}
+
+	int fd = open(in, O_RDONLY);
+	struct stat st;
+	if ( fd < 0 || fstat(fd, &st) != 0 ) {
+		perror(in);
+		return FAILURE;
+	}
+	if ( st.st_size < (off_t)sizeof(EventFileHdr) ) {
+		fprintf(stderr, "%s: too short\n", in);
+		return FAILURE;
+	}
+	char *map = (char *)mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if ( map == MAP_FAILED ) {
+		perror("mmap");
+		return FAILURE;
+	}
+	madvise(map, st.st_size, MADV_SEQUENTIAL);
+
+	EventFileHdr *hdr = (EventFileHdr *)map;
+	if ( 0 != strncmp(hdr->magic, EVENT_MAGIC, sizeof(hdr->magic)) || hdr->version != EVENT_VERSION || hdr->recordSize != sizeof(EventRecord) ) {
+		fprintf(stderr, "%s: not an event log of this version\n", in);
+		return FAILURE;
+	}
+
+	FILE *fp = out != NULL ? fopen(out, "w") : stdout;
+	if ( fp == NULL ) {
+		perror(out);
+		return FAILURE;
+	}
+	static char fpbuf[1 << 20];
+	setvbuf(fp, fpbuf, _IOFBF, sizeof(fpbuf));
+
+	int magicNumber = 0;
+	for ( const char *c = MAGIC_NUMBER; *c != 0; c++ ) {
+		magicNumber += (int)*c;
+	}
+	fprintf(fp, "%x\n", magicNumber);
+
+	EventRecord *records = (EventRecord *)(hdr + 1);
+	size_t count = (st.st_size - sizeof(EventFileHdr)) / sizeof(EventRecord);
+	char node[32];
+	char peer[32];
+
+	for ( size_t i = 0; i < count; i++ ) {
+		EventRecord *r = &records[i];
+		if ( r->type == EV_NONE ) {
+			// unwritten tail of a log that was not closed
+			break;
+		}
+		formatAddr(node, r->node);
+		formatAddr(peer, r->peer);
+		switch ( r->type ) {
+			case EV_JOIN:
+				fprintf(fp, "\n %s [%d] Node %s joined at time %d", node, r->time, peer, r->time);
+				break;
+			case EV_REMOVE:
+				fprintf(fp, "\n %s [%d] Node %s removed at time %d", node, r->time, peer, r->time);
+				break;
+			case EV_FAIL:
+				fprintf(fp, "\n %s [%d] Node failed at time=%d", node, r->time, r->time);
+				break;
+			case EV_GROUP_FAIL:
+				fprintf(fp, "\n %s [%d] Node failed at time = %d", node, r->time, r->time);
+				break;
+			case EV_SEND:
+				if ( all ) {
+					fprintf(fp, "\n %s [%d] Sent %d B to %s", node, r->time, r->size, peer);
+				}
+				break;
+			case EV_RECV:
+				if ( all ) {
+					fprintf(fp, "\n %s [%d] Received %d B from %s", node, r->time, r->size, peer);
+				}
+				break;
+		}
+	}
+
+	fclose(fp);
+	munmap(map, st.st_size);
+	close(fd);
+	return SUCCESS;
+}
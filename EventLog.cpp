@@ -0,0 +1,73 @@
+/**********************************
+ * FILE NAME: EventLog.cpp
+ *
+ * DESCRIPTION: Definition of the binary event log
+ **********************************/
+
+#include <sys/mman.h>
+#include "EventLog.h"
+
+/**
+ * Constructor. Truncates path and writes the file header.
+ */
+EventLog::EventLog(const char *path): map(NULL), mapped(0), used(0) {
+	fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if ( fd < 0 ) {
+		perror(path);
+		exit(1);
+	}
+	grow();
+
+	EventFileHdr *hdr = (EventFileHdr *)map;
+	memset(hdr, 0, sizeof(EventFileHdr));
+	strcpy(hdr->magic, EVENT_MAGIC);
+	hdr->version = EVENT_VERSION;
+	hdr->recordSize = sizeof(EventRecord);
+	used = sizeof(EventFileHdr);
+}
+
+/**
+ * Destructor. Cuts the file down to the records actually written.
+ */
+EventLog::~EventLog() {
+	munmap(map, mapped);
+	if ( ftruncate(fd, used) != 0 ) {
+		perror("ftruncate");
+	}
+	close(fd);
+}
+
+/**
+ * FUNCTION NAME: grow
+ *
+ * DESCRIPTION: Extend the file by EVENT_CHUNK bytes and map it again
+ */
+void EventLog::grow() {
+	if ( map != NULL ) {
+		munmap(map, mapped);
+	}
+	mapped += EVENT_CHUNK;
+	if ( ftruncate(fd, mapped) != 0 ) {
+		perror("ftruncate");
+		exit(1);
+	}
+	map = (char *)mmap(NULL, mapped, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if ( map == MAP_FAILED ) {
+		perror("mmap");
+		exit(1);
+	}
+}
+
+/**
+ * FUNCTION NAME: append
+ *
+ * DESCRIPTION: Copy records to the end of the file
+ */
+void EventLog::append(const EventRecord *records, size_t count) {
+	size_t bytes = count * sizeof(EventRecord);
+	while ( used + bytes > mapped ) {
+		grow();
+	}
+	memcpy(map + used, records, bytes);
+	used += bytes;
+}
@@ -0,0 +1,84 @@
+/**********************************
+ * FILE NAME: EventLog.h
+ *
+ * DESCRIPTION: Header file of the binary event log
+ **********************************/
+
+#ifndef _EVENTLOG_H_
+#define _EVENTLOG_H_
+
+#include <stdint.h>
+#include "stdincludes.h"
+
+/*
+ * Macros
+ */
+#define EVENT_LOG_FILE "events.bin"
+#define EVENT_MAGIC "MP1EVTS"
+#define EVENT_VERSION 1
+// The file is grown by this many bytes at a time
+#define EVENT_CHUNK (4 << 20)
+
+/**
+ * Event types. 0 marks the unwritten tail of a file that was not closed. A single
+ * failure and the failure of half the group are logged with different texts.
+ */
+enum EventKinds {
+	EV_NONE,
+	EV_JOIN,
+	EV_REMOVE,
+	EV_SEND,
+	EV_RECV,
+	EV_FAIL,
+	EV_GROUP_FAIL
+};
+
+/**
+ * STRUCT NAME: EventFileHdr
+ *
+ * DESCRIPTION: Start of the file
+ */
+typedef struct EventFileHdr {
+	char magic[8];
+	uint32_t version;
+	uint32_t recordSize;
+}EventFileHdr;
+
+/**
+ * STRUCT NAME: EventRecord
+ *
+ * DESCRIPTION: One event. node is the node that logged it; peer is the member that
+ * 				joined or was removed, or the other end of a message.
+ */
+typedef struct EventRecord {
+	int32_t time;
+	// message bytes for EV_SEND and EV_RECV
+	int32_t size;
+	uint8_t type;
+	uint8_t reserved;
+	char node[6];
+	char peer[6];
+	uint8_t pad[2];
+}EventRecord;
+
+/**
+ * CLASS NAME: EventLog
+ *
+ * DESCRIPTION: Append-only writer of event records through a memory mapping of the
+ * 				file. Not thread safe: parallel phases capture their events in Log
+ * 				and append them after the barrier.
+ */
+class EventLog {
+private:
+	int fd;
+	char *map;
+	size_t mapped;
+	size_t used;
+	void grow();
+public:
+	EventLog(const char *path);
+	virtual ~EventLog();
+	void append(const EventRecord *records, size_t count);
+};
+
+#endif /* _EVENTLOG_H_ */
@@ -6,12 +6,46 @@
 
 #include "Log.h"
 
+thread_local int Log::capture = -1;
+
+static FILE *fp;
+static FILE *fp2;
+static int numwrites;
+// background writer, NULL when logging synchronously
+static AsyncLog *writer;
+// binary event log, NULL unless EVENT_LOG is set
+static EventLog *events;
+
 /**
  * Constructor
  */
 Log::Log(Params *p) {
 	par = p;
 	firstTime = false;
+	partitions = 0;
+	// opened here rather than on the first line logged, which may come from several
+	// workers of the parallel engine at once
+	if ( fp == NULL ) {
+		numwrites = 0;
+		fp = fopen(DBG_LOG, "w");
+		fp2 = fopen(STATS_LOG, "w");
+		if ( par->ASYNC_LOG ) {
+			writer = new AsyncLog(fp, fp2, par->LOG_FLUSH_BYTES, par->LOG_FLUSH_MS);
+		}
+
+		int magicNumber = 0;
+		string magic = MAGIC_NUMBER;
+		int len = magic.length();
+		for ( int i = 0; i < len; i++ ) {
+			magicNumber += (int)magic.at(i);
+		}
+		char line[16];
+		write(false, line, sprintf(line, "%x\n", magicNumber));
+		firstTime = true;
+	}
+	if ( par->EVENT_LOG && events == NULL ) {
+		events = new EventLog(EVENT_LOG_FILE);
+	}
 }
 
 /**
@@ -20,6 +54,10 @@ Log::Log(Params *p) {
 Log::Log(const Log &anotherLog) {
 	this->par = anotherLog.par;
 	this->firstTime = anotherLog.firstTime;
+	this->partitions = anotherLog.partitions;
+	this->dbgCaptures = anotherLog.dbgCaptures;
+	this->statsCaptures = anotherLog.statsCaptures;
+	this->eventCaptures = anotherLog.eventCaptures;
 }
 
 /**
@@ -28,13 +66,26 @@ Log::Log(const Log &anotherLog) {
 Log& Log::operator = (const Log& anotherLog) {
 	this->par = anotherLog.par;
 	this->firstTime = anotherLog.firstTime;
+	this->partitions = anotherLog.partitions;
+	this->dbgCaptures = anotherLog.dbgCaptures;
+	this->statsCaptures = anotherLog.statsCaptures;
+	this->eventCaptures = anotherLog.eventCaptures;
 	return *this;
 }
 
 /**
  * Destructor
  */
-Log::~Log() {}
+Log::~Log() {
+	if ( writer != NULL ) {
+		delete writer;
+		writer = NULL;
+	}
+	if ( events != NULL ) {
+		delete events;
+		events = NULL;
+	}
+}
 
 /**
  * FUNCTION NAME: LOG
@@ -43,32 +94,11 @@ Log::~Log() {}
  */
 void Log::LOG(Address *addr, const char * str, ...) {
 
-	static FILE *fp;
-	static FILE *fp2;
 	va_list vararglist;
-	static char buffer[30000];
-	static int numwrites;
-	static char stdstring[30];
-	static char stdstring2[40];
-	static char stdstring3[40]; 
-	static int dbg_opened=0;
-
-	if(dbg_opened != 639){
-		numwrites=0;
-
-		stdstring2[0]=0;
-
-		strcpy(stdstring3, stdstring2);
-
-		strcat(stdstring2, DBG_LOG);
-		strcat(stdstring3, STATS_LOG);
-
-		fp = fopen(stdstring2, "w");
-		fp2 = fopen(stdstring3, "w");
-
-		dbg_opened=639;
-	}
-	else 
+	// per thread so that partitions of the parallel engine can log concurrently
+	static thread_local char buffer[30000];
+	static thread_local char line[30100];
+	static thread_local char stdstring[30];
 
 	sprintf(stdstring, "%d.%d.%d.%d:%d ", addr->addr[0], addr->addr[1], addr->addr[2], addr->addr[3], *(short *)&addr->addr[4]);
 
@@ -76,36 +106,38 @@ void Log::LOG(Address *addr, const char * str, ...) {
 	vsprintf(buffer, str, vararglist);
 	va_end(vararglist);
 
-	if (!firstTime) {
-		int magicNumber = 0;
-		string magic = MAGIC_NUMBER;
-		int len = magic.length();
-		for ( int i = 0; i < len; i++ ) {
-			magicNumber += (int)magic.at(i);
-		}
-		fprintf(fp, "%x\n", magicNumber);
-		firstTime = true;
+	bool toStats = (memcmp(buffer, "#STATSLOG#", 10)==0);
+	int len = snprintf(line, sizeof(line), "\n %s[%d] %s", stdstring, par->getcurrtime(), buffer);
+	len = min(len, (int)sizeof(line) - 1);
+
+	if ( capture >= 0 ) {
+		string &out = toStats ? statsCaptures[capture] : dbgCaptures[capture];
+		out.append(line, len);
+		return;
 	}
 
-	if(memcmp(buffer, "#STATSLOG#", 10)==0){
-		fprintf(fp2, "\n %s", stdstring);
-		fprintf(fp2, "[%d] ", par->getcurrtime());
+	write(toStats, line, len);
+}
 
-		fprintf(fp2, buffer);
+/**
+ * FUNCTION NAME: write
+ *
+ * DESCRIPTION: Hand text to the background writer, or write it right away when
+ * 				logging synchronously
+ */
+void Log::write(bool toStats, const char *text, int len) {
+	if ( writer != NULL ) {
+		writer->push(toStats, text, len);
+		return;
 	}
-	else{
-		fprintf(fp, "\n %s", stdstring);
-		fprintf(fp, "[%d] ", par->getcurrtime());
-		fprintf(fp, buffer);
 
-	}
+	fwrite(text, 1, len, toStats ? fp2 : fp);
 
 	if(++numwrites >= MAXWRITES){
 		fflush(fp);
 		fflush(fp2);
 		numwrites=0;
 	}
-
 }
 
 /**
@@ -114,7 +146,11 @@ void Log::LOG(Address *addr, const char * str, ...) {
  * DESCRIPTION: To Log a node add
  */
 void Log::logNodeAdd(Address *thisNode, Address *addedAddr) {
-	static char stdstring[60];
+	logEvent(EV_JOIN, thisNode, addedAddr, 0);
+	if ( !LOG_ENABLED(LEVEL_EVENT) ) {
+		return;
+	}
+	char stdstring[60];
 	sprintf(stdstring, "Node %d.%d.%d.%d:%d joined at time %d", addedAddr->addr[0], addedAddr->addr[1], addedAddr->addr[2], addedAddr->addr[3], *(short *)&addedAddr->addr[4], par->getcurrtime());
     LOG(thisNode, stdstring);
 }
@@ -125,7 +161,113 @@ void Log::logNodeAdd(Address *thisNode, Address *addedAddr) {
  * DESCRIPTION: To log a node remove
  */
 void Log::logNodeRemove(Address *thisNode, Address *removedAddr) {
-	static char stdstring[60];
+	logEvent(EV_REMOVE, thisNode, removedAddr, 0);
+	if ( !LOG_ENABLED(LEVEL_EVENT) ) {
+		return;
+	}
+	char stdstring[60];
 	sprintf(stdstring, "Node %d.%d.%d.%d:%d removed at time %d", removedAddr->addr[0], removedAddr->addr[1], removedAddr->addr[2], removedAddr->addr[3], *(short *)&removedAddr->addr[4], par->getcurrtime());
     LOG(thisNode, stdstring);
 }
+
+/**
+ * FUNCTION NAME: logEvent
+ *
+ * DESCRIPTION: Record an event in the binary event log, if there is one
+ *
+ * RETURNS:
+ * handle of the record for cancelEvent while it is captured, -1 otherwise
+ */
+int64_t Log::logEvent(int type, Address *node, Address *peer, int size) {
+	if ( events == NULL ) {
+		return -1;
+	}
+
+	EventRecord record;
+	memset(&record, 0, sizeof(EventRecord));
+	record.time = par->getcurrtime();
+	record.size = size;
+	record.type = type;
+	memcpy(record.node, node->addr, sizeof(record.node));
+	memcpy(record.peer, peer->addr, sizeof(record.peer));
+
+	if ( capture >= 0 ) {
+		eventCaptures[capture].push_back(record);
+		return ((int64_t)capture << 32) | (eventCaptures[capture].size() - 1);
+	}
+	events->append(&record, 1);
+	return -1;
+}
+
+/**
+ * FUNCTION NAME: cancelEvent
+ *
+ * DESCRIPTION: Take back a captured record before the captures are flushed
+ */
+void Log::cancelEvent(int64_t record) {
+	eventCaptures[record >> 32][record & 0xffffffff].type = EV_NONE;
+}
+
+/**
+ * FUNCTION NAME: setCaptures
+ *
+ * DESCRIPTION: Create the capture buffers of each partition of the parallel engine,
+ * 				those of the receive phase first
+ */
+void Log::setCaptures(int count) {
+	partitions = count;
+	dbgCaptures.resize(2 * count);
+	statsCaptures.resize(2 * count);
+	eventCaptures.resize(2 * count);
+}
+
+/**
+ * FUNCTION NAME: startCapture
+ *
+ * DESCRIPTION: Make lines logged by the calling thread go to the capture buffers of
+ * 				partition for the receive phase or the node loops, or straight to the
+ * 				files when it is -1
+ */
+void Log::startCapture(int partition, bool receiving) {
+	capture = partition < 0 ? -1 : (receiving ? partition : partitions + partition);
+}
+
+/**
+ * FUNCTION NAME: cancelled
+ *
+ * DESCRIPTION: Whether record was taken back with cancelEvent
+ */
+static bool cancelled(const EventRecord &record) {
+	return record.type == EV_NONE;
+}
+
+/**
+ * FUNCTION NAME: flushCaptures
+ *
+ * DESCRIPTION: Write the captured lines in the order of a serial tick: the receive
+ * 				phase by ascending node, then the node loops by descending node.
+ * 				Partition 0 holds the highest nodes, so the receive buffers are
+ * 				written from the last partition down and the loop buffers from the
+ * 				first partition up.
+ */
+void Log::flushCaptures() {
+	for ( int k = 0; k < 2 * partitions; k++ ) {
+		int i = k < partitions ? partitions - 1 - k : k;
+		if ( !dbgCaptures[i].empty() ) {
+			write(false, dbgCaptures[i].data(), dbgCaptures[i].size());
+		}
+		if ( !statsCaptures[i].empty() ) {
+			write(true, statsCaptures[i].data(), statsCaptures[i].size());
+		}
+		if ( events != NULL && !eventCaptures[i].empty() ) {
+			vector<EventRecord> &captured = eventCaptures[i];
+			captured.erase(remove_if(captured.begin(), captured.end(), cancelled), captured.end());
+			if ( !captured.empty() ) {
+				events->append(captured.data(), captured.size());
+			}
+		}
+		dbgCaptures[i].clear();
+		statsCaptures[i].clear();
+		eventCaptures[i].clear();
+	}
+}
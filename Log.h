@@ -10,16 +10,40 @@
 #include "stdincludes.h"
 #include "Params.h"
 #include "Member.h"
+#include "AsyncLog.h"
+#include "EventLog.h"
 
 /*
  * Macros
  */
-// number of writes after which to flush file
+// number of writes after which to flush file when logging synchronously
 #define MAXWRITES 1
 #define MAGIC_NUMBER "CS425"
 #define DBG_LOG "dbg.log"
 #define STATS_LOG "stats.log"
 
+// Log levels, from the most to the least verbose. Membership events are the
+// joins, removals and failures the grader reads from dbg.log.
+#define LEVEL_TRACE 0
+#define LEVEL_DEBUG 1
+#define LEVEL_INFO 2
+#define LEVEL_EVENT 3
+#define LEVEL_NONE 4
+// Lowest level compiled in, e.g. make LOG_LEVEL=0 for a full trace
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LEVEL_EVENT
+#endif
+#define LOG_ENABLED(level) ((level) >= LOG_LEVEL)
+
+// The condition is a constant, so a disabled level compiles to nothing and its
+// arguments are never evaluated
+#define LOG_AT(level, log, addr, ...) \
+	do { if ( LOG_ENABLED(level) ) (log)->LOG(addr, __VA_ARGS__); } while ( 0 )
+#define LOG_TRACE(log, addr, ...) LOG_AT(LEVEL_TRACE, log, addr, __VA_ARGS__)
+#define LOG_DEBUG(log, addr, ...) LOG_AT(LEVEL_DEBUG, log, addr, __VA_ARGS__)
+#define LOG_INFO(log, addr, ...) LOG_AT(LEVEL_INFO, log, addr, __VA_ARGS__)
+#define LOG_EVENT(log, addr, ...) LOG_AT(LEVEL_EVENT, log, addr, __VA_ARGS__)
+
 /**
  * CLASS NAME: Log
  *
@@ -29,6 +53,15 @@ class Log{
 private:
 	Params *par;
 	bool firstTime;
+	// Lines logged during a parallel phase, one set of buffers per partition for
+	// the receive phase and another for the node loops
+	int partitions;
+	vector<string> dbgCaptures;
+	vector<string> statsCaptures;
+	vector< vector<EventRecord> > eventCaptures;
+	// Partition the calling thread logs into, -1 to write right away
+	static thread_local int capture;
+	void write(bool toStats, const char *text, int len);
 public:
 	Log(Params *p);
 	Log(const Log &anotherLog);
@@ -37,6 +70,11 @@ public:
 	void LOG(Address *, const char * str, ...);
 	void logNodeAdd(Address *, Address *);
 	void logNodeRemove(Address *, Address *);
+	int64_t logEvent(int type, Address *node, Address *peer, int size);
+	void cancelEvent(int64_t record);
+	void setCaptures(int count);
+	void startCapture(int partition, bool receiving = false);
+	void flushCaptures();
 };
 
 #endif /* _LOG_H_ */
@@ -0,0 +1,389 @@
+/**********************************
+ * FILE NAME: LogAnalyzer.cpp
+ *
+ * DESCRIPTION: Grades a dbg.log in one pass, with the verdicts of Grader_verbose.sh
+ * 				and statistics on failure detection latency
+ **********************************/
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unordered_map>
+#include "stdincludes.h"
+
+/**
+ * STRUCT NAME: Removal
+ *
+ * DESCRIPTION: A "removed" line: logger removed target at time
+ */
+typedef struct Removal {
+	int logger;
+	int target;
+	int time;
+	bool operator <(const Removal &other) const {
+		if ( logger != other.logger ) return logger < other.logger;
+		if ( target != other.target ) return target < other.target;
+		return time < other.time;
+	}
+	bool operator ==(const Removal &other) const {
+		return logger == other.logger && target == other.target && time == other.time;
+	}
+}Removal;
+
+/**
+ * CLASS NAME: Analysis
+ *
+ * DESCRIPTION: Join and remove indexes built from the log
+ */
+class Analysis {
+public:
+	// dense index of every address seen
+	unordered_map<long long, int> index;
+	vector<string> names;
+	// joins[logger] = nodes logger saw join
+	vector< vector<int> > joins;
+	vector<Removal> removals;
+	// failure time per node, -1 if it did not fail
+	vector<int> failedAt;
+	vector<int> failed;
+	// removal lines naming each node, as logger or target
+	vector<int> involved;
+	// node whose membership list is followed, -1 if none, and whether each node is
+	// on it after the lines read so far
+	int listOwner = -1;
+	vector<bool> listed;
+
+	int node(const char *p, const char *end, const char **next);
+	void parseLine(const char *p, const char *end);
+	void indexRemovals();
+	int joinScore();
+	int completenessScore();
+	int accuracyScore();
+	int listScore();
+	void latency();
+};
+
+/**
+ * FUNCTION NAME: node
+ *
+ * DESCRIPTION: Parse an address printed as a.b.c.d:port and return its index
+ *
+ * RETURNS:
+ * index, -1 if p does not start with an address
+ */
+int Analysis::node(const char *p, const char *end, const char **next) {
+	long long key = 0;
+	const char *start = p;
+	for ( int part = 0; part < 5; part++ ) {
+		char *stop;
+		long v = strtol(p, &stop, 10);
+		if ( stop == p || stop > end ) {
+			return -1;
+		}
+		// four address bytes and a 16-bit port
+		key = part < 4 ? (key << 8) | (v & 0xff) : (key << 16) | (v & 0xffff);
+		p = stop;
+		if ( part < 4 ) {
+			if ( p >= end || *p != (part < 3 ? '.' : ':') ) {
+				return -1;
+			}
+			p++;
+		}
+	}
+	*next = p;
+
+	unordered_map<long long, int>::iterator it = index.find(key);
+	if ( it != index.end() ) {
+		return it->second;
+	}
+	int id = names.size();
+	index[key] = id;
+	names.push_back(string(start, p - start));
+	joins.resize(id + 1);
+	failedAt.push_back(-1);
+	listed.push_back(false);
+	return id;
+}
+
+/**
+ * FUNCTION NAME: parseLine
+ *
+ * DESCRIPTION: Index one line of the form " addr [time] message"
+ */
+void Analysis::parseLine(const char *p, const char *end) {
+	static const char NODE[] = "Node ";
+	static const char JOINED[] = " joined at time ";
+	static const char REMOVED[] = " removed at time ";
+	static const char FAILED[] = "Node failed at time";
+
+	while ( p < end && *p == ' ' ) p++;
+	int logger = node(p, end, &p);
+	if ( logger < 0 ) {
+		return;
+	}
+	while ( p < end && *p == ' ' ) p++;
+	if ( p >= end || *p != '[' ) {
+		return;
+	}
+	int time = atoi(p + 1);
+	p = (const char *)memchr(p, ']', end - p);
+	if ( p == NULL || p + 2 > end ) {
+		return;
+	}
+	p += 2;
+
+	if ( end - p >= (long)strlen(FAILED) && 0 == memcmp(p, FAILED, strlen(FAILED)) ) {
+		if ( failedAt[logger] < 0 ) {
+			failed.push_back(logger);
+		}
+		failedAt[logger] = time;
+		return;
+	}
+	if ( end - p < (long)strlen(NODE) || 0 != memcmp(p, NODE, strlen(NODE)) ) {
+		return;
+	}
+	int peer = node(p + strlen(NODE), end, &p);
+	if ( peer < 0 ) {
+		return;
+	}
+	if ( end - p >= (long)strlen(JOINED) && 0 == memcmp(p, JOINED, strlen(JOINED)) ) {
+		joins[logger].push_back(peer);
+		if ( logger == listOwner ) {
+			listed[peer] = true;
+		}
+	}
+	else if ( end - p >= (long)strlen(REMOVED) && 0 == memcmp(p, REMOVED, strlen(REMOVED)) ) {
+		Removal r = {logger, peer, time};
+		removals.push_back(r);
+		if ( logger == listOwner ) {
+			listed[peer] = false;
+		}
+	}
+}
+
+/**
+ * FUNCTION NAME: indexRemovals
+ *
+ * DESCRIPTION: Drop duplicate removal lines, like sort -u, and count the lines
+ * 				naming each node
+ */
+void Analysis::indexRemovals() {
+	sort(removals.begin(), removals.end());
+	removals.erase(unique(removals.begin(), removals.end()), removals.end());
+
+	involved.assign(names.size(), 0);
+	for ( size_t r = 0; r < removals.size(); r++ ) {
+		involved[removals[r].target]++;
+		if ( removals[r].logger != removals[r].target ) {
+			involved[removals[r].logger]++;
+		}
+	}
+}
+
+/**
+ * FUNCTION NAME: joinScore
+ *
+ * DESCRIPTION: 10 if every node logged the join of every other node
+ */
+int Analysis::joinScore() {
+	int n = names.size();
+	for ( int i = 0; i < n; i++ ) {
+		vector<int> &seen = joins[i];
+		sort(seen.begin(), seen.end());
+		seen.erase(unique(seen.begin(), seen.end()), seen.end());
+		int others = seen.size() - (binary_search(seen.begin(), seen.end(), i) ? 1 : 0);
+		if ( others != n - 1 ) {
+			return 0;
+		}
+	}
+	return n > 0 ? 10 : 0;
+}
+
+/**
+ * FUNCTION NAME: completenessScore
+ *
+ * DESCRIPTION: Share of failed nodes removed by every survivor, out of 10
+ */
+int Analysis::completenessScore() {
+	int f = failed.size();
+	if ( f == 0 ) {
+		return 0;
+	}
+	int survivors = names.size() - f;
+	int passed = 0;
+	for ( int i = 0; i < f; i++ ) {
+		if ( involved[failed[i]] >= survivors ) {
+			passed++;
+		}
+	}
+	return 10 * passed / f;
+}
+
+/**
+ * FUNCTION NAME: accuracyScore
+ *
+ * DESCRIPTION: Share of failed nodes for which every other removal line is the removal
+ * 				of another failed node by a survivor, out of 10
+ */
+int Analysis::accuracyScore() {
+	int f = failed.size();
+	if ( f == 0 || removals.empty() ) {
+		return 0;
+	}
+	int survivors = names.size() - f;
+	int passed = 0;
+	for ( int i = 0; i < f; i++ ) {
+		int others = removals.size() - involved[failed[i]];
+		if ( others == (f - 1) * survivors ) {
+			passed++;
+		}
+	}
+	return 10 * passed / f;
+}
+
+/**
+ * FUNCTION NAME: listScore
+ *
+ * DESCRIPTION: 10 if the membership list of listOwner, as its joined and removed lines
+ * 				leave it, holds exactly the nodes that did not fail
+ */
+int Analysis::listScore() {
+	for ( size_t i = 0; i < names.size(); i++ ) {
+		if ( listed[i] != (failedAt[i] < 0) ) {
+			return 0;
+		}
+	}
+	return names.size() > 0 ? 10 : 0;
+}
+
+/**
+ * FUNCTION NAME: latency
+ *
+ * DESCRIPTION: Print how long survivors took to remove failed nodes
+ */
+void Analysis::latency() {
+	vector<int> lat;
+	vector<int> full;
+	int falseRemovals = 0;
+
+	// longest latency per failed node, by node index
+	full.assign(names.size(), -1);
+	for ( size_t r = 0; r < removals.size(); r++ ) {
+		int failTime = failedAt[removals[r].target];
+		if ( failTime < 0 || removals[r].time < failTime ) {
+			falseRemovals++;
+			continue;
+		}
+		int l = removals[r].time - failTime;
+		lat.push_back(l);
+		full[removals[r].target] = max(full[removals[r].target], l);
+	}
+
+	printf("Failed nodes...................%d of %d\n", (int)failed.size(), (int)names.size());
+	printf("False removals.................%d\n", falseRemovals);
+	if ( lat.empty() ) {
+		printf("Detection latency..............no removals of failed nodes\n");
+		return;
+	}
+	sort(lat.begin(), lat.end());
+	double sum = 0;
+	for ( size_t i = 0; i < lat.size(); i++ ) {
+		sum += lat[i];
+	}
+	printf("Detection latency..............min %d avg %.1f p50 %d p99 %d max %d (%d removals)\n",
+			lat.front(), sum / lat.size(), lat[lat.size() / 2], lat[(lat.size() * 99) / 100], lat.back(), (int)lat.size());
+	for ( size_t i = 0; i < failed.size(); i++ ) {
+		if ( full[failed[i]] >= 0 ) {
+			printf("  %s failed at %d, last removal after %d\n", names[failed[i]].c_str(), failedAt[failed[i]], full[failed[i]]);
+		}
+		else {
+			printf("  %s failed at %d, never removed\n", names[failed[i]].c_str(), failedAt[failed[i]]);
+		}
+	}
+}
+
+/**********************************
+ * FUNCTION NAME: main
+ *
+ * DESCRIPTION: Usage: LogAnalyzer [-s | -l addr] [dbg.log]
+ * 				Prints the join, completeness and accuracy verdicts and the detection
+ * 				latency. -s prints only the three scores out of 10, for scripts.
+ * 				-l prints only the score out of 10 of the final membership list
+ * 				of node addr, such as the one a census rebuilds.
+ **********************************/
+int main(int argc, char *argv[]) {
+	bool scoresOnly = false;
+	const char *owner = NULL;
+	const char *in = "dbg.log";
+	int arg = 1;
+
+	if ( arg < argc && 0 == strcmp(argv[arg], "-s") ) {
+		scoresOnly = true;
+		arg++;
+	}
+	else if ( arg + 1 < argc && 0 == strcmp(argv[arg], "-l") ) {
+		owner = argv[arg + 1];
+		arg += 2;
+	}
+	if ( arg < argc ) {
+		in = argv[arg];
+	}
+
+	int fd = open(in, O_RDONLY);
+	struct stat st;
+	if ( fd < 0 || fstat(fd, &st) != 0 ) {
+		perror(in);
+		return FAILURE;
+	}
+
+	Analysis a;
+	if ( owner != NULL ) {
+		const char *next;
+		a.listOwner = a.node(owner, owner + strlen(owner), &next);
+		if ( a.listOwner < 0 ) {
+			fprintf(stderr, "%s: not an address\n", owner);
+			return FAILURE;
+		}
+	}
+	if ( st.st_size > 0 ) {
+		char *map = (char *)mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if ( map == MAP_FAILED ) {
+			perror("mmap");
+			return FAILURE;
+		}
+		madvise(map, st.st_size, MADV_SEQUENTIAL);
+
+		const char *p = map;
+		const char *end = map + st.st_size;
+		while ( p < end ) {
+			const char *eol = (const char *)memchr(p, '\n', end - p);
+			if ( eol == NULL ) {
+				eol = end;
+			}
+			a.parseLine(p, eol);
+			p = eol + 1;
+		}
+		munmap(map, st.st_size);
+	}
+	close(fd);
+
+	a.indexRemovals();
+
+	if ( owner != NULL ) {
+		printf("%d\n", a.listScore());
+		return SUCCESS;
+	}
+
+	int join = a.joinScore();
+	int completeness = a.completenessScore();
+	int accuracy = a.accuracyScore();
+
+	if ( scoresOnly ) {
+		printf("%d %d %d\n", join, completeness, accuracy);
+		return SUCCESS;
+	}
+	printf("Checking Join..................%d/10\n", join);
+	printf("Checking Completeness..........%d/10\n", completeness);
+	printf("Checking Accuracy..............%d/10\n", accuracy);
+	a.latency();
+	return SUCCESS;
+}
@@ -16,7 +16,8 @@
  * You can add new members to the class if you think it
  * is necessary for your logic to work
  */
-MP1Node::MP1Node(Member *member, Params *params, EmulNet *emul, Log *log, Address *address) {
+MP1Node::MP1Node(Member *member, Params *params, Transport *emul, Log *log, Address *address):
+	expiryWheel(TFAIL + TREMOVE + 1, 0), rumors(SWIM_QUEUE_CAPACITY) {
 	for( int i = 0; i < 6; i++ ) {
 		NULLADDR[i] = 0;
 	}
@@ -25,12 +26,33 @@ MP1Node::MP1Node(Member *member, Params *params, EmulNet *emul, Log *log, Addres
 	this->log = log;
 	this->par = params;
 	this->memberNode->addr = *address;
+	// own random stream, so nodes can run on any thread in any order
+	this->random.setSeed(params->SEED, getAddressId(address));
+	if ( partialView() ) {
+		int active = 31 - __builtin_clz(max(params->EN_GPSZ, 2)) + VIEW_ACTIVE_EXTRA;
+		view.reset(MemberTable::pack(address), active, VIEW_PASSIVE_FACTOR * active);
+	}
+}
+
+/**
+ * FUNCTION NAME: releaseParts
+ *
+ * DESCRIPTION: Release the payloads of a serialized list and empty it
+ */
+static void releaseParts(vector<Payload *> *parts) {
+	for ( size_t i = 0; i < parts->size(); i++ ) {
+		(*parts)[i]->release();
+	}
+	parts->clear();
 }
 
 /**
  * Destructor of the MP1Node class
  */
-MP1Node::~MP1Node() {}
+MP1Node::~MP1Node() {
+	releaseParts(&listSnapshot);
+	releaseParts(&deltaSnapshot);
+}
 
 /**
  * FUNCTION NAME: recvLoop
@@ -70,17 +92,13 @@ void MP1Node::nodeStart(char *servaddrstr, short servport) {
 
     // Self booting routines
     if( initThisNode(&joinaddr) == -1 ) {
-#ifdef DEBUGLOG
-        log->LOG(&memberNode->addr, "init_thisnode failed. Exit.");
-#endif
+        LOG_INFO(log, &memberNode->addr, "init_thisnode failed. Exit.");
         exit(1);
     }
 
     if( !introduceSelfToGroup(&joinaddr) ) {
         finishUpThisNode();
-#ifdef DEBUGLOG
-        log->LOG(&memberNode->addr, "Unable to join self to group. Exiting.");
-#endif
+        LOG_INFO(log, &memberNode->addr, "Unable to join self to group. Exiting.");
         exit(1);
     }
 
@@ -119,36 +137,36 @@ int MP1Node::initThisNode(Address *joinaddr) {
  */
 int MP1Node::introduceSelfToGroup(Address *joinaddr) {
 	MessageHdr *msg;
-#ifdef DEBUGLOG
-    static char s[1024];
-#endif
 
     if ( 0 == memcmp((char *)&(memberNode->addr.addr), (char *)&(joinaddr->addr), sizeof(memberNode->addr.addr))) {
         // I am the group booter (first process to join the group). Boot up the group
-#ifdef DEBUGLOG
-        log->LOG(&memberNode->addr, "Starting up group...");
-#endif
+        LOG_DEBUG(log, &memberNode->addr, "Starting up group...");
         memberNode->inGroup = true;
-        addNodeToMemberList(1, 0, 0);
+        if (partialView()) {
+            viewLearn(MemberTable::pack(&memberNode->addr));
+        } else {
+            addNodeToMemberList(1, 0, 0);
+        }
     }
     else {
+        if (partialView()) {
+            viewLearn(MemberTable::pack(&memberNode->addr));
+        }
         size_t msgsize = sizeof(MessageHdr) + sizeof(joinaddr->addr) + sizeof(long) + 1;
-        msg = (MessageHdr *) malloc(msgsize * sizeof(char));
+        Payload *payload = Payload::create(msgsize);
+        msg = (MessageHdr *) payload->getData();
 
         // create JOINREQ message: format of data is {struct Address myaddr}
         msg->msgType = JOINREQ;
         memcpy((char *)(msg + 1), &memberNode->addr.addr, sizeof(memberNode->addr.addr));
         memcpy((char *)(msg + 1) + 1 + sizeof(memberNode->addr.addr), &memberNode->heartbeat, sizeof(long));
 
-#ifdef DEBUGLOG
-        sprintf(s, "Trying to join...");
-        log->LOG(&memberNode->addr, s);
-#endif
+        LOG_DEBUG(log, &memberNode->addr, "Trying to join...");
 
         // send JOINREQ message to introducer member
-        emulNet->ENsend(&memberNode->addr, joinaddr, (char *)msg, msgsize);
+        emulNet->ENsend(&memberNode->addr, joinaddr, payload);
 
-        free(msg);
+        payload->release();
     }
 
     return 1;
@@ -161,9 +179,23 @@ int MP1Node::introduceSelfToGroup(Address *joinaddr) {
  * DESCRIPTION: Wind up this node and clean up state
  */
 int MP1Node::finishUpThisNode(){
-   /*
-    * Your code goes here
-    */
+    // Give back the messages nobody will handle
+    while ( !memberNode->mp1q.empty() ) {
+        Payload::fromData((char *)memberNode->mp1q.front().elt)->release();
+        memberNode->mp1q.pop();
+    }
+    syncMemberList();
+    return SUCCESS;
+}
+
+/**
+ * FUNCTION NAME: syncMemberList
+ *
+ * DESCRIPTION: Copy the membership table into memberNode->memberList, the
+ * 				MemberListEntry view kept for code reading the Member directly
+ */
+void MP1Node::syncMemberList() {
+    members.copyTo(&memberNode->memberList);
 }
 
 /**
@@ -206,6 +238,8 @@ void MP1Node::checkMessages() {
     	size = memberNode->mp1q.front().size;
     	memberNode->mp1q.pop();
     	recvCallBack((void *)memberNode, (char *)ptr, size);
+    	// the buffer is the payload handed over by ENrecv, return it to the pool
+    	Payload::fromData((char *)ptr)->release();
     }
     return;
 }
@@ -216,98 +250,197 @@ void MP1Node::checkMessages() {
  * DESCRIPTION: Message handler for different message types
  */
 bool MP1Node::recvCallBack(void *env, char *data, int size ) {
-    static char s[1024];
     MessageHdr *msg = reinterpret_cast<MessageHdr*>(data);
+
+    if (size < (int)sizeof(MessageHdr)) {
+        return false;
+    }
 	
 	switch (msg->msgType) {
 	    case JOINREQ: {
             Address *addr = reinterpret_cast<Address*>(data + sizeof(MessageHdr));
             long heartbeat = *(data + (size - sizeof(long)) );
 
-#ifdef DEBUGLOG
-            sprintf(s, "JOINREQ Received from %s", addr->getAddress().c_str());
-	        log->LOG(&memberNode->addr, s);
-#endif
+            LOG_DEBUG(log, &memberNode->addr, "JOINREQ Received from %s", addr->getAddress().c_str());
             recvJoinRequest(addr, heartbeat);
             break;
 	    }
-        default: {
-            string sdata (data, (size_t)size);
-#ifdef DEBUGLOG
-            sprintf(s, "Received %s!", sdata.c_str());
-	        log->LOG(&memberNode->addr, s);
-#endif
-            // deserialize and copy membership list
-            stringstream ss(sdata);
-            string st;
-            getline(ss, st, '#');
-            size_t size;
-            int msgType = stoi(st, &size);
-            switch (msgType) {
-                case JOINREP: {
-#ifdef DEBUGLOG
-	                log->LOG(&memberNode->addr, "JOINREP Received");
-#endif
-                    memberNode->inGroup = true;
-                }
-                case GOSSIP: {
-#ifdef DEBUGLOG
-	                log->LOG(&memberNode->addr, "GOSSIP Received");
-#endif
-                }
-                default: {
-                    // parse membershiplist
-                    getline(ss, st, '|');
-                    int mlsize = stoi(st, &size);
-                    for (int i = 0; i < mlsize; ++i) {
-                        // id
-                        getline(ss, st, '#');
-                        int id = stoi(st, &size);
-                        // port
-                        getline(ss, st, '#');
-                        short port = (short)stoi(st, &size);
-                        // Heartbeat
-                        getline(ss, st, '#');
-                        long heartbeat = stol(st, &size);
-                        // Timestamp
-                        getline(ss, st, '|');
-                        long timestamp = stol(st, &size);
-
-                        addNodeToMemberList(id, port, heartbeat);
-                    }
-                }
-            };
+        case JOINREP:
+        case GOSSIP: {
+            ListDecoder dec(data, size, &listScratch);
+            if (!dec.valid()) {
+                LOG_INFO(log, &memberNode->addr, "Dropping malformed membership list (%d B)", size);
+                return false;
+            }
+            LOG_TRACE(log, &memberNode->addr, "%s Received with %d entries, part %d of %d", msg->msgType == JOINREP ? "JOINREP" : "GOSSIP", dec.getCount(), dec.getPart() + 1, dec.getParts());
+            if (dec.getParts() > 1) {
+                assembleList(&dec);
+            }
+            // Join replies carry the same shared list snapshot as gossip, so
+            // the first list that reaches a joining node admits it to the group
+            bool admitted = !memberNode->inGroup;
+            if (admitted) {
+                memberNode->inGroup = true;
+            }
+            // merge membership list, read in place from the message
+            for (int i = 0; i < dec.getCount(); ++i) {
+                addNodeToMemberList(dec.getid(i), dec.getport(i), dec.getheartbeat(i));
+            }
+            // the part listing this node may not have come
+            if (admitted && members.find(MemberTable::pack(&memberNode->addr)) < 0) {
+                addNodeToMemberList(getAddressId(&memberNode->addr), getAddressPort(&memberNode->addr), memberNode->heartbeat);
+            }
             break;
         }
+        case PING:
+        case ACK:
+        case PING_REQ:
+            return swimRecv(msg->msgType, data, size);
+        case FORWARDJOIN:
+        case NEIGHBOR:
+        case NEIGHBOR_REP:
+        case DISCONNECT:
+        case SHUFFLE:
+        case SHUFFLE_REP:
+        case KEEPALIVE:
+        case LISTREQ:
+        case LISTREP:
+            return viewRecv(msg->msgType, data, size);
+        default: {
+            LOG_INFO(log, &memberNode->addr, "Dropping message of unknown type %d", msg->msgType);
+            return false;
+        }
 	};
+	return true;
 }
 
 
 void MP1Node::addNodeToMemberList(int id, short port, long heartbeat) {
-    
-    if (id > memberNode->memberList.size()) {
-        memberNode->memberList.resize(id);
+    if (swimMode()) {
+        // lists only carry incarnations under SWIM
+        swimAlive(MemberTable::pack(id, port), heartbeat);
+        return;
     }
 
-    MemberListEntry* oldm = &memberNode->memberList.at(id-1);
-    if (oldm->getid() == id) {
+    uint64_t key = MemberTable::pack(id, port);
+    int index = members.find(key);
+
+    if (index >= 0) {
         // Ya existe, se actualiza heartbeat
-        if (heartbeat > oldm->getheartbeat()) {
-            oldm->setheartbeat(heartbeat);
-            oldm->settimestamp(par->getcurrtime());
+        if (heartbeat > members.getheartbeat(index)) {
+            bool revived = members.gettimestamp(index) + TFAIL + 1 <= expiryWheel.getCurrent();
+            members.setheartbeat(index, heartbeat);
+            members.settimestamp(index, par->getcurrtime());
+            listChanged = true;
+            if (revived) {
+                // suspected member is alive after all, its pending item is the removal
+                addLive(index);
+                expiryWheel.schedule(key, par->getcurrtime() + TFAIL + 1);
+            }
+            // a live member keeps its pending deadline, expireMembers re-arms it
         }
     } else {
-        MemberListEntry m (id, port, heartbeat, par->getcurrtime());
-
-        memberNode->memberList.at(id-1) = m;
-        ++neighbors;
+        index = insertMember(id, port, heartbeat);
+        listChanged = true;
+        if (key != MemberTable::pack(&memberNode->addr)) {
+            expiryWheel.schedule(key, par->getcurrtime() + TFAIL + 1);
+            addLive(index);
+        }
         
-        string str_addr = to_string(id) + ":" + to_string(port);
-        Address node_addr (str_addr);
+        Address node_addr;
+        MemberTable::unpack(key, &node_addr);
         log->logNodeAdd(&memberNode->addr, &node_addr);
     }
 }
 
+/**
+ * FUNCTION NAME: insertMember
+ *
+ * DESCRIPTION: Add a member heard of now to the table, not yet a gossip target
+ *
+ * RETURNS:
+ * its table row
+ */
+int MP1Node::insertMember(int id, short port, long heartbeat) {
+    int index = members.insert(id, port, heartbeat, par->getcurrtime());
+    livePos.push_back(-1);
+    return index;
+}
+
+/**
+ * FUNCTION NAME: clearMembers
+ *
+ * DESCRIPTION: Empty the table and the live index with it
+ */
+void MP1Node::clearMembers() {
+    members.clear();
+    live.clear();
+    livePos.clear();
+}
+
+/**
+ * FUNCTION NAME: addLive
+ *
+ * DESCRIPTION: Make the member at index a gossip target
+ */
+void MP1Node::addLive(int index) {
+    if (livePos[index] < 0) {
+        livePos[index] = live.size();
+        live.push_back(index);
+        if (swimMode()) {
+            // at a random place among the members not yet probed this round, so that
+            // nodes do not all probe in join order
+            size_t pos = probeNext + random.below(live.size() - probeNext);
+            swap(live[pos], live.back());
+            livePos[live.back()] = live.size() - 1;
+            livePos[index] = pos;
+        }
+    }
+}
+
+/**
+ * FUNCTION NAME: removeLive
+ *
+ * DESCRIPTION: Stop gossiping to the member at index. The last live member takes its place.
+ */
+void MP1Node::removeLive(int index) {
+    int pos = livePos[index];
+    if (pos >= 0 && swimMode() && (size_t)pos < probeNext) {
+        // trade places with the last member probed this round, so that the member
+        // taking its slot below has not been probed yet either
+        probeNext--;
+        live[pos] = live[probeNext];
+        livePos[live[pos]] = pos;
+        live[probeNext] = index;
+        pos = probeNext;
+        livePos[index] = pos;
+    }
+    if (pos >= 0) {
+        live[pos] = live.back();
+        livePos[live[pos]] = pos;
+        live.pop_back();
+        livePos[index] = -1;
+    }
+}
+
+/**
+ * FUNCTION NAME: removeMember
+ *
+ * DESCRIPTION: Drop the member at index from the list. The last member moves into its
+ * 				place, its live slot follows it.
+ */
+void MP1Node::removeMember(int index) {
+    removeLive(index);
+    int moved = members.erase(index);
+    if (moved >= 0) {
+        livePos[index] = livePos[moved];
+        if (livePos[index] >= 0) {
+            live[livePos[index]] = index;
+        }
+    }
+    livePos.pop_back();
+}
+
 int MP1Node::getAddressId(Address* node) {
     string node_addr = node->getAddress();
     size_t pos = node_addr.find(":");
@@ -321,81 +454,224 @@ short MP1Node::getAddressPort(Address* node) {
 }
 
 void MP1Node::recvJoinRequest(Address *node, long heartbeat) {
+    if (partialView()) {
+        viewJoin(MemberTable::pack(node));
+        return;
+    }
 	
 	int id = getAddressId(node);
 	short port = getAddressPort(node);
 	
 	addNodeToMemberList(id, port, heartbeat);
 
-    sendJoinReply(node);
+    // Answered from nodeLoopOps with this tick's list snapshot
+    pendingJoinReplies.push_back(*node);
 }
 
-void MP1Node::sendJoinReply(Address *node) {
-    std::stringstream ss;
-    MessageHdr msg;
-    msg.msgType = JOINREP;
-    ss << msg.msgType;
+/**
+ * FUNCTION NAME: assembleList
+ *
+ * DESCRIPTION: Keep track of the parts received of a list sent in several messages.
+ * 				Each part is a list of its own and is merged as it arrives, so only
+ * 				which parts came is kept. A list still missing parts when a newer one
+ * 				from the same sender begins, or LIST_ASSEMBLY_TIMEOUT ticks after its
+ * 				first part, is given up.
+ */
+void MP1Node::assembleList(ListDecoder *dec) {
+    Address from;
+    memcpy(from.addr, dec->getFrom(), sizeof(from.addr));
+    uint64_t key = MemberTable::pack(&from);
+    int now = par->getcurrtime();
 
-    // Serialize memberList
-    std::vector<MemberListEntry> *memberList = &memberNode->memberList;
-    ss << "#" << neighbors - failed;
-    for (std::vector<MemberListEntry>::iterator it = memberList->begin(); it != memberList->end(); ++it) {
-        if (it->getid() == 0 || it->gettimestamp() < par->getcurrtime() - TFAIL) {
-            // Dont send failed or removed nodes
+    ListAssembly *a = NULL;
+    for (size_t i = 0; i < assemblies.size(); ) {
+        ListAssembly &other = assemblies[i];
+        bool stale = now - other.startedAt > LIST_ASSEMBLY_TIMEOUT;
+        if (other.from == key && other.snapshot == dec->getSnapshot() && !stale) {
+            a = &other;
+        } else if (other.from == key || stale) {
+            LOG_INFO(log, &memberNode->addr, "Missing %d of %d parts of list %d from %s", (int)other.have.size() - other.received, (int)other.have.size(), other.snapshot, from.getAddress().c_str());
+            other = assemblies.back();
+            assemblies.pop_back();
             continue;
         }
-        ss << "|" << it->getid() << "#" << it->getport() << "#" << 
-            it->getheartbeat() << "#" << it->gettimestamp();
+        i++;
+    }
+    if (a == NULL) {
+        ListAssembly fresh;
+        fresh.from = key;
+        fresh.snapshot = dec->getSnapshot();
+        fresh.startedAt = now;
+        fresh.received = 0;
+        fresh.have.assign(dec->getParts(), false);
+        assemblies.push_back(fresh);
+        a = &assemblies.back();
+    }
+    if ((int)a->have.size() != dec->getParts() || a->have[dec->getPart()]) {
+        return;
+    }
+    a->have[dec->getPart()] = true;
+    if (++a->received == (int)a->have.size()) {
+        LOG_DEBUG(log, &memberNode->addr, "Received all %d parts of list %d from %s", a->received, a->snapshot, from.getAddress().c_str());
+        *a = assemblies.back();
+        assemblies.pop_back();
+    }
+}
+
+/**
+ * FUNCTION NAME: encodeMemberList
+ *
+ * DESCRIPTION: Serialize into parts the live entries of the membership list that
+ * 				changed at or after tick since, in the LIST_CODEC encoding. Each part
+ * 				holds as many entries as fit in MAX_MSG_SIZE, and there is always at
+ * 				least one.
+ */
+void MP1Node::encodeMemberList(enum MsgTypes msgType, long since, vector<Payload *> *parts) {
+    selected.clear();
+    if (swimMode()) {
+        // every member not known dead, with its incarnation
+        for (int index = 0; index < members.size(); index++) {
+            if (members.getstate(index) != MEMBER_DEAD) {
+                selected.push_back(index);
+            }
+        }
+    } else {
+        // Dont send failed nodes
+        long from = max(since, (long)par->getcurrtime() - TFAIL);
+        members.selectSince(from, &selected);
     }
 
-#ifdef DEBUGLOG
-        static char s[1024];
-        sprintf(s, "Sending JOINREP [%s] to %s", ss.str().c_str(), node->getAddress().c_str());
-	    log->LOG(&memberNode->addr, s);
-#endif    
-    emulNet->ENsend(&memberNode->addr, node, ss.str());
+    int codec = par->LIST_CODEC;
+    if (codec == VARINT_CODEC) {
+        // small deltas between neighbours
+        MemberTable &m = members;
+        sort(selected.begin(), selected.end(), [&m](int a, int b) {
+            return m.getid(a) != m.getid(b) ? m.getid(a) < m.getid(b) : m.getport(a) < m.getport(b);
+        });
+    }
+
+    int limit = par->MAX_MSG_SIZE - TRANSPORT_HEADROOM;
+    int snapshot = snapshotSeq++;
+    size_t i = 0;
+    releaseParts(parts);
+    do {
+        ListEncoder enc(&snapshotBuf, msgType, codec, memberNode->addr.addr, snapshot, parts->size(), 0);
+        for (; i < selected.size() && enc.fits(limit); i++) {
+            int index = selected[i];
+            enc.add(members.getid(index), members.getport(index), members.getheartbeat(index));
+        }
+        int size = enc.finish();
+        parts->push_back(Payload::create(snapshotBuf.data(), size));
+    } while (i < selected.size());
+    for (size_t part = 0; part < parts->size(); part++) {
+        ListEncoder::setParts((*parts)[part]->getData(), parts->size());
+    }
 }
 
-void MP1Node::sendGossip() {
+/**
+ * FUNCTION NAME: getListSnapshot
+ *
+ * DESCRIPTION: Return the serialized membership list shared by every message sent this tick.
+ * 				It is rebuilt only when the list changed since the last build.
+ */
+vector<Payload *> *MP1Node::getListSnapshot() {
+    if (listSnapshot.empty() || listChanged) {
+        encodeMemberList(GOSSIP, 0, &listSnapshot);
+        listChanged = false;
+        // the delta is a subset of the list, rebuild it too
+        deltaSnapshotTime = -1;
+    }
+    return &listSnapshot;
+}
+
+/**
+ * FUNCTION NAME: getDeltaSnapshot
+ *
+ * DESCRIPTION: Return the serialized entries that changed within the last DELTA_WINDOW ticks.
+ * 				The window moves every tick, so it is rebuilt at most once per tick.
+ */
+vector<Payload *> *MP1Node::getDeltaSnapshot() {
+    getListSnapshot();
+    if (deltaSnapshotTime != par->getcurrtime()) {
+        encodeMemberList(GOSSIP, par->getcurrtime() - DELTA_WINDOW + 1, &deltaSnapshot);
+        deltaSnapshotTime = par->getcurrtime();
+    }
+    return &deltaSnapshot;
+}
+
+void MP1Node::sendJoinReply(Address *node, vector<Payload *> *snapshot) {
+    LOG_DEBUG(log, &memberNode->addr, "Sending JOINREP (%d parts) to %s", (int)snapshot->size(), node->getAddress().c_str());
+    for (size_t i = 0; i < snapshot->size(); i++) {
+        emulNet->ENsend(&memberNode->addr, node, (*snapshot)[i]);
+    }
+}
+
+void MP1Node::sendGossip(vector<Payload *> *snapshot) {
     int messages = GOSSIP_CNT;
-    std::vector<MemberListEntry> *memberList = &memberNode->memberList;
     
-    if (memberList->size() < messages) {
-        messages = memberList->size();
+    if ((int)live.size() < messages) {
+        messages = live.size();
     }
     
-    std::stringstream ss;
-    MessageHdr msg;
-    msg.msgType = GOSSIP;
-    ss << msg.msgType;
-
-    // Serialize memberList
-    ss << "#" << neighbors - failed;
-    for (std::vector<MemberListEntry>::iterator it = memberList->begin() ; 
-        it != memberList->end(); ++it) {
-            if (it->getid() == 0 || it->gettimestamp() < par->getcurrtime() - TFAIL) {
-                // Dont send failed or removed nodes
-                continue;
-            }
-        ss << "|" << it->getid() << "#" << it->getport() << "#" << 
-            it->getheartbeat() << "#" << it->gettimestamp();
+    gossipTargets.clear();
+    // partial Fisher-Yates shuffle: the first messages slots of live become
+    // distinct recipients drawn uniformly from the live members
+    for (int k = 0; k < messages; k++) {
+        int j = k + random.below(live.size() - k);
+        swap(live[k], live[j]);
+        livePos[live[k]] = k;
+        livePos[live[j]] = j;
+
+        Address node_addr;
+        MemberTable::unpack(members.getkey(live[k]), &node_addr);
+
+        LOG_TRACE(log, &memberNode->addr, "Sending GOSSIP (%d parts) to %s", (int)snapshot->size(), node_addr.getAddress().c_str());
+        gossipTargets.push_back(node_addr);
     }
-    
-    while (messages--) {
-        // choose random receipient
-        int v1 = rand() % memberList->size();
-        MemberListEntry mle = memberList->at(v1);
-        if (mle.getid() == 0 || mle.gettimestamp() < par->getcurrtime() - TFAIL)
+
+    // one payload per part for the whole round
+    if (!gossipTargets.empty()) {
+        for (size_t i = 0; i < snapshot->size(); i++) {
+            emulNet->ENsendMulti(&memberNode->addr, gossipTargets.data(), gossipTargets.size(), (*snapshot)[i]);
+        }
+    }
+}
+
+/**
+ * FUNCTION NAME: expireMembers
+ *
+ * DESCRIPTION: Suspect members not heard of for TFAIL ticks and remove them after
+ * 				TREMOVE more. Only the members whose deadline is due this tick are touched.
+ */
+void MP1Node::expireMembers() {
+    dueTimers.clear();
+    expiryWheel.advance(par->getcurrtime(), &dueTimers);
+    for (size_t i = 0; i < dueTimers.size(); i++) {
+        bool removal = dueTimers[i].key < 0;
+        uint64_t key = removal ? -dueTimers[i].key : dueTimers[i].key;
+        int index = members.find(key);
+        if (index < 0) {
+            // already removed
             continue;
-        string str_addr = to_string(mle.getid()) + ":" + to_string(mle.getport());
-        Address node_addr (str_addr);
+        }
+        long suspectAt = members.gettimestamp(index) + TFAIL + 1;
+        if (!removal && suspectAt > dueTimers[i].deadline) {
+            // heard of since this deadline was set, wait for the new one
+            expiryWheel.schedule(key, suspectAt);
+        } else if (!removal && livePos[index] >= 0) {
+            // Just became stale, drop it from the snapshot
+            listChanged = true;
+            removeLive(index);
+            expiryWheel.schedule(-(int64_t)key, suspectAt + TREMOVE);
+        } else if (removal && dueTimers[i].deadline == suspectAt + TREMOVE) {
+            Address node_addr;
+            MemberTable::unpack(key, &node_addr);
+            log->logNodeRemove(&memberNode->addr, &node_addr);
 
-#ifdef DEBUGLOG
-        static char s[1024];
-        sprintf(s, "Sending GOSSIP [%s] to %s", ss.str().c_str(), node_addr.getAddress().c_str());
-	    log->LOG(&memberNode->addr, s);
-#endif
-        emulNet->ENsend(&memberNode->addr, &node_addr, ss.str());
+            removeMember(index);
+            listChanged = true;
+        }
+        // otherwise the member was revived since this removal was set
     }
 }
 
@@ -407,35 +683,780 @@ void MP1Node::sendGossip() {
  * 				Propagate your membership list
  */
 void MP1Node::nodeLoopOps() {
+    if (partialView()) {
+        viewLoopOps();
+        return;
+    }
+    if (swimMode()) {
+        swimLoopOps();
+        return;
+    }
 
 	memberNode->heartbeat += 1;
 	
-	memberNode->memberList.at(getAddressId(&memberNode->addr) - 1).setheartbeat(memberNode->heartbeat);
-	memberNode->memberList.at(getAddressId(&memberNode->addr) - 1).settimestamp(par->getcurrtime());
-
-	// Busco nodos de mi member list expirados (TREMOVE+TFAIL)
-	// Y los elimino de la lista
-	std::vector<MemberListEntry> *memberList = &memberNode->memberList;
-	failed = 0;
-    for (std::vector<MemberListEntry>::iterator it = memberList->begin() ; 
-        it != memberList->end(); ++it) {
-        if (it->getid() == 0)
+	int self = members.find(MemberTable::pack(&memberNode->addr));
+	members.setheartbeat(self, memberNode->heartbeat);
+	members.settimestamp(self, par->getcurrtime());
+	listChanged = true;
+
+	expireMembers();
+
+    vector<Payload *> *snapshot = getListSnapshot();
+    for (size_t i = 0; i < pendingJoinReplies.size(); i++) {
+        sendJoinReply(&pendingJoinReplies[i], snapshot);
+    }
+    pendingJoinReplies.clear();
+
+    if (par->DELTA_GOSSIP && memberNode->heartbeat % FULL_SYNC_PERIOD != 0) {
+        sendGossip(getDeltaSnapshot());
+    } else {
+        sendGossip(snapshot);
+    }
+    return;
+}
+
+/**
+ * FUNCTION NAME: swimLoopOps
+ *
+ * DESCRIPTION: SWIM counterpart of nodeLoopOps: settle expired suspicions, answer
+ * 				joins, follow up on unanswered probes and probe the next member.
+ * 				A node sends one PING per tick whatever the group size.
+ */
+void MP1Node::swimLoopOps() {
+    swimExpire();
+
+    if (!pendingJoinReplies.empty()) {
+        vector<Payload *> *snapshot = getListSnapshot();
+        for (size_t i = 0; i < pendingJoinReplies.size(); i++) {
+            sendJoinReply(&pendingJoinReplies[i], snapshot);
+        }
+        pendingJoinReplies.clear();
+    }
+
+    swimCheckProbes();
+    swimProbe();
+}
+
+/**
+ * FUNCTION NAME: swimExpire
+ *
+ * DESCRIPTION: Declare dead the suspects that did not refute in time, and forget the
+ * 				dead members after SWIM_DEAD_TIMEOUT
+ */
+void MP1Node::swimExpire() {
+    dueTimers.clear();
+    expiryWheel.advance(par->getcurrtime(), &dueTimers);
+    for (size_t i = 0; i < dueTimers.size(); i++) {
+        bool removal = dueTimers[i].key < 0;
+        uint64_t key = removal ? -dueTimers[i].key : dueTimers[i].key;
+        int index = members.find(key);
+        if (index < 0) {
+            continue;
+        }
+        int since = members.gettimestamp(index);
+        if (!removal && members.getstate(index) == MEMBER_SUSPECT && dueTimers[i].deadline == since + SWIM_SUSPECT_TIMEOUT) {
+            swimDead(index);
+        } else if (removal && members.getstate(index) == MEMBER_DEAD && dueTimers[i].deadline == since + SWIM_DEAD_TIMEOUT) {
+            removeMember(index);
+        }
+        // otherwise the member changed state since this deadline was set
+    }
+}
+
+/**
+ * FUNCTION NAME: swimCheckProbes
+ *
+ * DESCRIPTION: Ask SWIM_PING_REQS members to probe the targets that did not ACK within
+ * 				SWIM_ACK_TIMEOUT, and suspect those still silent after SWIM_PROBE_TIMEOUT
+ */
+void MP1Node::swimCheckProbes() {
+    size_t kept = 0;
+    for (size_t i = 0; i < probes.size(); i++) {
+        SwimProbe p = probes[i];
+        int index = members.find(p.target);
+        if (index < 0 || members.getstate(index) == MEMBER_DEAD) {
+            continue;
+        }
+        Address target;
+        MemberTable::unpack(p.target, &target);
+
+        if (par->getcurrtime() >= p.sentAt + SWIM_PROBE_TIMEOUT) {
+            LOG_DEBUG(log, &memberNode->addr, "No ACK from %s, suspecting it", target.getAddress().c_str());
+            swimSuspect(p.target, members.getheartbeat(index));
+            // last chance: the PING carries the suspicion, so the target can refute it
+            sendSwim(PING, &target, ++probeSeq, &memberNode->addr, &target);
             continue;
-        if (it->gettimestamp() < par->getcurrtime() - TFAIL - TREMOVE) {
-            
-            string str_addr = to_string(it->getid()) + ":" + to_string(it->getport());
-            Address node_addr (str_addr);
+        }
+        if (!p.indirect && par->getcurrtime() >= p.sentAt + SWIM_ACK_TIMEOUT) {
+            // distinct random helpers among the other members
+            int want = min(SWIM_PING_REQS, (int)live.size() - (livePos[index] >= 0 ? 1 : 0));
+            helpers.clear();
+            while ((int)helpers.size() < want) {
+                int row = live[random.below(live.size())];
+                if (row != index && find(helpers.begin(), helpers.end(), row) == helpers.end()) {
+                    helpers.push_back(row);
+                }
+            }
+            for (size_t h = 0; h < helpers.size(); h++) {
+                Address helper;
+                MemberTable::unpack(members.getkey(helpers[h]), &helper);
+                sendSwim(PING_REQ, &helper, p.seq, &memberNode->addr, &target);
+            }
+            p.indirect = true;
+        }
+        probes[kept++] = p;
+    }
+    probes.resize(kept);
+}
+
+/**
+ * FUNCTION NAME: swimProbe
+ *
+ * DESCRIPTION: PING the next member. Members are probed in rounds, each a fresh random
+ * 				order of the live array, so every member is probed once per round.
+ */
+void MP1Node::swimProbe() {
+    if (live.empty()) {
+        return;
+    }
+    if (probeNext >= live.size()) {
+        for (size_t k = live.size() - 1; k > 0; k--) {
+            size_t j = random.below(k + 1);
+            swap(live[k], live[j]);
+            livePos[live[k]] = k;
+            livePos[live[j]] = j;
+        }
+        probeNext = 0;
+    }
+
+    SwimProbe p;
+    p.seq = ++probeSeq;
+    p.target = members.getkey(live[probeNext++]);
+    p.sentAt = par->getcurrtime();
+    p.indirect = false;
+    probes.push_back(p);
+
+    Address target;
+    MemberTable::unpack(p.target, &target);
+    LOG_TRACE(log, &memberNode->addr, "Sending PING %d to %s", p.seq, target.getAddress().c_str());
+    sendSwim(PING, &target, p.seq, &memberNode->addr, &target);
+}
+
+/**
+ * FUNCTION NAME: swimRecv
+ *
+ * DESCRIPTION: Handle a PING, ACK or PING_REQ and the updates piggybacked on it
+ */
+bool MP1Node::swimRecv(enum MsgTypes msgType, char *data, int size) {
+    SwimDecoder dec(data, size);
+    if (!dec.valid()) {
+        LOG_INFO(log, &memberNode->addr, "Dropping malformed SWIM message (%d B)", size);
+        return false;
+    }
+    const SwimMsgHdr *hdr = dec.getHdr();
+    Address from, origin, target;
+    memcpy(from.addr, hdr->from, sizeof(from.addr));
+    memcpy(origin.addr, hdr->origin, sizeof(origin.addr));
+    memcpy(target.addr, hdr->target, sizeof(target.addr));
+
+    // a message straight from a member shows it alive at its incarnation
+    swimAlive(MemberTable::pack(&from), hdr->incarnation);
+    for (int i = 0; i < dec.getCount(); i++) {
+        const SwimUpdate &u = dec.getUpdate(i);
+        uint64_t key = MemberTable::pack(u.id, u.port);
+        switch (u.state) {
+            case SWIM_ALIVE:
+                swimAlive(key, u.incarnation);
+                break;
+            case SWIM_SUSPECT:
+                swimSuspect(key, u.incarnation);
+                break;
+            case SWIM_CONFIRM:
+                swimConfirm(key, u.incarnation);
+                break;
+        }
+    }
+
+    switch (msgType) {
+        case PING:
+            // the ACK goes straight to the node that started the probe
+            sendSwim(ACK, &origin, hdr->seq, &origin, &memberNode->addr);
+            break;
+        case PING_REQ:
+            sendSwim(PING, &target, hdr->seq, &origin, &target);
+            break;
+        case ACK:
+            for (size_t i = 0; i < probes.size(); i++) {
+                if (probes[i].seq == hdr->seq) {
+                    probes.erase(probes.begin() + i);
+                    break;
+                }
+            }
+            break;
+        default:
+            break;
+    }
+    return true;
+}
+
+/**
+ * FUNCTION NAME: swimAlive
+ *
+ * DESCRIPTION: Member key is alive at incarnation: add it, or clear a suspicion or
+ * 				death older than incarnation
+ */
+void MP1Node::swimAlive(uint64_t key, int incarnation) {
+    bool self = key == MemberTable::pack(&memberNode->addr);
+    int index = members.find(key);
+    Address node_addr;
+    MemberTable::unpack(key, &node_addr);
+
+    if (index < 0) {
+        index = insertMember(MemberTable::keyid(key), MemberTable::keyport(key), incarnation);
+        listChanged = true;
+        log->logNodeAdd(&memberNode->addr, &node_addr);
+        if (!self) {
+            addLive(index);
+            addRumor(key, SWIM_ALIVE, incarnation);
+        }
+        return;
+    }
+    if (self || incarnation <= members.getheartbeat(index)) {
+        return;
+    }
+
+    int state = members.getstate(index);
+    if (state == MEMBER_DEAD) {
+        // back after a false death: joins again
+        log->logNodeAdd(&memberNode->addr, &node_addr);
+        addLive(index);
+    }
+    members.setstate(index, MEMBER_ALIVE);
+    members.setheartbeat(index, incarnation);
+    members.settimestamp(index, par->getcurrtime());
+    listChanged = true;
+    addRumor(key, SWIM_ALIVE, incarnation);
+}
+
+/**
+ * FUNCTION NAME: swimSuspect
+ *
+ * DESCRIPTION: Member key is suspected at incarnation. It is declared dead unless it
+ * 				refutes with a higher incarnation within SWIM_SUSPECT_TIMEOUT.
+ */
+void MP1Node::swimSuspect(uint64_t key, int incarnation) {
+    if (key == MemberTable::pack(&memberNode->addr)) {
+        swimRefute(incarnation);
+        return;
+    }
+    int index = members.find(key);
+    if (index < 0) {
+        return;
+    }
+    int state = members.getstate(index);
+    int known = members.getheartbeat(index);
+    if ((state == MEMBER_ALIVE && incarnation >= known) || (state == MEMBER_SUSPECT && incarnation > known)) {
+        members.setstate(index, MEMBER_SUSPECT);
+        members.setheartbeat(index, incarnation);
+        members.settimestamp(index, par->getcurrtime());
+        listChanged = true;
+        expiryWheel.schedule(key, par->getcurrtime() + SWIM_SUSPECT_TIMEOUT);
+        addRumor(key, SWIM_SUSPECT, incarnation);
+    }
+}
+
+/**
+ * FUNCTION NAME: swimConfirm
+ *
+ * DESCRIPTION: Member key was declared dead by another member
+ */
+void MP1Node::swimConfirm(uint64_t key, int incarnation) {
+    if (key == MemberTable::pack(&memberNode->addr)) {
+        swimRefute(incarnation);
+        return;
+    }
+    int index = members.find(key);
+    if (index >= 0 && members.getstate(index) != MEMBER_DEAD) {
+        swimDead(index);
+    }
+}
+
+/**
+ * FUNCTION NAME: swimDead
+ *
+ * DESCRIPTION: Remove the member at index from the group. Its row stays, marked dead,
+ * 				for SWIM_DEAD_TIMEOUT ticks.
+ */
+void MP1Node::swimDead(int index) {
+    uint64_t key = members.getkey(index);
+    Address node_addr;
+    MemberTable::unpack(key, &node_addr);
+    log->logNodeRemove(&memberNode->addr, &node_addr);
+
+    members.setstate(index, MEMBER_DEAD);
+    members.settimestamp(index, par->getcurrtime());
+    removeLive(index);
+    listChanged = true;
+    expiryWheel.schedule(-(int64_t)key, par->getcurrtime() + SWIM_DEAD_TIMEOUT);
+    addRumor(key, SWIM_CONFIRM, members.getheartbeat(index));
+}
+
+/**
+ * FUNCTION NAME: swimRefute
+ *
+ * DESCRIPTION: This node was suspected at incarnation: announce a higher one
+ */
+void MP1Node::swimRefute(int incarnation) {
+    if (incarnation < this->incarnation) {
+        return;
+    }
+    this->incarnation = incarnation + 1;
+    uint64_t key = MemberTable::pack(&memberNode->addr);
+    int self = members.find(key);
+    if (self >= 0) {
+        members.setheartbeat(self, this->incarnation);
+    }
+    listChanged = true;
+    addRumor(key, SWIM_ALIVE, this->incarnation);
+}
+
+/**
+ * FUNCTION NAME: addRumor
+ *
+ * DESCRIPTION: Disseminate an update about member key, replacing any older one
+ */
+void MP1Node::addRumor(uint64_t key, int state, int incarnation) {
+    SwimUpdate u;
+    u.id = MemberTable::keyid(key);
+    u.port = MemberTable::keyport(key);
+    u.state = state;
+    u.incarnation = incarnation;
+    rumors.push(key, u);
+}
+
+/**
+ * FUNCTION NAME: rumorLimit
+ *
+ * DESCRIPTION: Times an update is piggybacked before it is retired: SWIM_LAMBDA times
+ * 				ceil(log2(N + 1)) for the N members this node knows alive, itself included
+ */
+int MP1Node::rumorLimit() {
+    unsigned int n = live.size() + 1;
+    return SWIM_LAMBDA * (32 - __builtin_clz(n));
+}
+
+/**
+ * FUNCTION NAME: sendSwim
+ *
+ * DESCRIPTION: Send a SWIM message carrying as many queued updates as fit in
+ * 				MAX_MSG_SIZE, first any update about the receiver itself, then the
+ * 				least sent ones
+ */
+void MP1Node::sendSwim(enum MsgTypes msgType, Address *to, int seq, Address *origin, Address *target) {
+    SwimEncoder enc(&swimBuf, msgType, seq, incarnation, memberNode->addr.addr, origin->addr, target->addr);
+    int budget = par->MAX_MSG_SIZE - TRANSPORT_HEADROOM - (int)sizeof(SwimMsgHdr);
+    rumors.fill(&enc, budget, MemberTable::pack(to), rumorLimit());
+
+    int size = enc.finish();
+    emulNet->ENsend(&memberNode->addr, to, swimBuf.data(), size);
+}
+
+/**
+ * FUNCTION NAME: viewLoopOps
+ *
+ * DESCRIPTION: Partial view counterpart of nodeLoopOps: drop the active peers that
+ * 				went silent, refill the active view from the passive one, send one
+ * 				keepalive and now and then shuffle. A node sends a bounded number of
+ * 				messages per tick whatever the group size.
+ */
+void MP1Node::viewLoopOps() {
+    memberNode->heartbeat += 1;
+
+    viewExpire();
+    viewRepair();
+
+    Address joinaddr = getJoinAddress();
+    if (0 == memcmp(memberNode->addr.addr, joinaddr.addr, sizeof(joinaddr.addr)) && par->getcurrtime() % VIEW_CENSUS_PERIOD == 0) {
+        requestMemberList();
+    }
+    if (censusAt >= 0 && par->getcurrtime() - censusAt >= VIEW_CENSUS_WINDOW) {
+        rebuildMemberList();
+    }
+
+    // one active peer per tick, so each hears from this node every activeSize() ticks
+    if (view.activeSize() > 0) {
+        uint64_t to = view.getActive(keepaliveNext++ % view.activeSize());
+        sendView(KEEPALIVE, to, 0, 0, 0, 0, NULL);
+    }
+
+    if (memberNode->heartbeat % VIEW_SHUFFLE_PERIOD == 0) {
+        viewShuffle();
+    }
+}
+
+/**
+ * FUNCTION NAME: viewExpire
+ *
+ * DESCRIPTION: Declare failed the active peers silent for VIEW_KEEPALIVE_MISSES rounds
+ * 				of keepalives, and take them off the membership list
+ */
+void MP1Node::viewExpire() {
+    int now = par->getcurrtime();
+    int timeout = VIEW_KEEPALIVE_MISSES * view.getActiveMax();
+    for (int i = view.activeSize() - 1; i >= 0; i--) {
+        if (now - view.getHeardAt(i) > timeout) {
+            uint64_t key = view.getActive(i);
+            view.removeActive(key);
+            int index = members.find(key);
+            if (index >= 0) {
+                Address node_addr;
+                MemberTable::unpack(key, &node_addr);
+                log->logNodeRemove(&memberNode->addr, &node_addr);
+                removeMember(index);
+            }
+        }
+    }
+}
+
+/**
+ * FUNCTION NAME: viewRepair
+ *
+ * DESCRIPTION: While the active view has room, ask one passive peer at a time to
+ * 				join it. The request has high priority when this node has no active
+ * 				peer left, and a peer that does not answer in time is forgotten.
+ */
+void MP1Node::viewRepair() {
+    int now = par->getcurrtime();
+    if (viewPending != 0 && now - viewPendingAt > VIEW_NEIGHBOR_TIMEOUT) {
+        viewPending = 0;
+    }
+    if (viewPending != 0 || view.activeFull() || view.passiveSize() == 0) {
+        return;
+    }
+    viewPending = view.randomPassive(&random);
+    viewPendingAt = now;
+    view.removePassive(viewPending);
+    sendView(NEIGHBOR, viewPending, 0, view.activeSize() == 0, 0, 0, NULL);
+}
+
+/**
+ * FUNCTION NAME: viewShuffle
+ *
+ * DESCRIPTION: Send this node and a sample of both views on a random walk; the node
+ * 				where it ends answers with a sample of its passive view, and both keep
+ * 				what they learnt in their passive views
+ */
+void MP1Node::viewShuffle() {
+    uint64_t to = view.randomActive(&random, 0);
+    if (to == 0) {
+        return;
+    }
+    viewPeers.clear();
+    viewPeers.push_back(MemberTable::pack(&memberNode->addr));
+    view.sample(true, VIEW_SHUFFLE_ACTIVE, to, &random, &viewPeers);
+    view.sample(false, VIEW_SHUFFLE_PASSIVE, 0, &random, &viewPeers);
+    sendView(SHUFFLE, to, MemberTable::pack(&memberNode->addr), 0, VIEW_ACTIVE_WALK, 0, &viewPeers);
+}
+
+/**
+ * FUNCTION NAME: viewRecv
+ *
+ * DESCRIPTION: Handle a partial view message. Any message from an active peer shows
+ * 				it alive.
+ */
+bool MP1Node::viewRecv(enum MsgTypes msgType, char *data, int size) {
+    ViewDecoder dec(data, size);
+    if (!dec.valid()) {
+        LOG_INFO(log, &memberNode->addr, "Dropping malformed view message (%d B)", size);
+        return false;
+    }
+    const ViewMsgHdr *hdr = dec.getHdr();
+    Address from, origin;
+    memcpy(from.addr, hdr->from, sizeof(from.addr));
+    memcpy(origin.addr, hdr->origin, sizeof(origin.addr));
+    uint64_t fromKey = MemberTable::pack(&from);
+    uint64_t originKey = MemberTable::pack(&origin);
+    view.heard(fromKey, par->getcurrtime());
+
+    switch (msgType) {
+        case FORWARDJOIN:
+            viewForwardJoin(fromKey, originKey, hdr->ttl);
+            break;
+        case NEIGHBOR: {
+            bool accept = hdr->flag || !view.activeFull() || view.isActive(fromKey);
+            if (accept) {
+                viewAddActive(fromKey);
+                // joining nodes are let in by the first peer taking them
+                memberNode->inGroup = true;
+            }
+            sendView(NEIGHBOR_REP, fromKey, 0, accept, 0, 0, NULL);
+            break;
+        }
+        case NEIGHBOR_REP:
+            // only answers to viewRepair matter, the others come from peers that
+            // already added this node
+            if (fromKey == viewPending) {
+                viewPending = 0;
+                if (hdr->flag) {
+                    viewAddActive(fromKey);
+                } else {
+                    view.addPassive(fromKey, &random);
+                }
+            }
+            break;
+        case DISCONNECT:
+            if (view.removeActive(fromKey)) {
+                view.addPassive(fromKey, &random);
+            }
+            break;
+        case SHUFFLE: {
+            uint64_t next = hdr->ttl > 0 ? view.randomActive(&random, fromKey) : 0;
+            viewPeers.clear();
+            for (int i = 0; i < dec.getCount(); i++) {
+                Address peer;
+                memcpy(peer.addr, dec.getPeer(i), sizeof(peer.addr));
+                viewPeers.push_back(MemberTable::pack(&peer));
+            }
+            if (next != 0) {
+                sendView(SHUFFLE, next, originKey, 0, hdr->ttl - 1, 0, &viewPeers);
+                break;
+            }
+            if (originKey == MemberTable::pack(&memberNode->addr)) {
+                break;
+            }
+            vector<uint64_t> received(viewPeers);
+            viewPeers.clear();
+            view.sample(false, received.size(), 0, &random, &viewPeers);
+            sendView(SHUFFLE_REP, originKey, 0, 0, 0, 0, &viewPeers);
+            for (size_t i = 0; i < received.size(); i++) {
+                view.addPassive(received[i], &random);
+            }
+            break;
+        }
+        case SHUFFLE_REP:
+            for (int i = 0; i < dec.getCount(); i++) {
+                Address peer;
+                memcpy(peer.addr, dec.getPeer(i), sizeof(peer.addr));
+                view.addPassive(MemberTable::pack(&peer), &random);
+            }
+            break;
+        case KEEPALIVE:
+            // the link is gone on this side, so the sender stops watching it
+            if (!view.isActive(fromKey)) {
+                sendView(DISCONNECT, fromKey, 0, 0, 0, 0, NULL);
+            }
+            break;
+        case LISTREQ:
+            viewCensus(fromKey, originKey, hdr->seq);
+            break;
+        case LISTREP:
+            if (hdr->seq == censusSeq && censusAt >= 0) {
+                censusKeys.push_back(fromKey);
+            }
+            break;
+        default:
+            break;
+    }
+    return true;
+}
+
+/**
+ * FUNCTION NAME: viewJoin
+ *
+ * DESCRIPTION: Introducer side of a join: take the new node as an active peer and
+ * 				send it on a random walk from each other active peer
+ */
+void MP1Node::viewJoin(uint64_t key) {
+    viewAddActive(key);
+    sendView(NEIGHBOR, key, 0, 1, 0, 0, NULL);
+    sendViewMulti(FORWARDJOIN, key, key, VIEW_ACTIVE_WALK, 0);
+}
+
+/**
+ * FUNCTION NAME: viewForwardJoin
+ *
+ * DESCRIPTION: Step of the random walk of joining node origin. The walk ends when it
+ * 				runs out of steps or peers, and its last node takes origin as an active
+ * 				peer; the node VIEW_PASSIVE_WALK steps in keeps it as a passive one.
+ */
+void MP1Node::viewForwardJoin(uint64_t from, uint64_t origin, int ttl) {
+    if (origin == MemberTable::pack(&memberNode->addr)) {
+        return;
+    }
+    uint64_t next = ttl > 0 ? view.randomActive(&random, from) : 0;
+    if (next == 0) {
+        viewAddActive(origin);
+        sendView(NEIGHBOR, origin, 0, 1, 0, 0, NULL);
+        return;
+    }
+    if (ttl == VIEW_PASSIVE_WALK) {
+        view.addPassive(origin, &random);
+    }
+    sendView(FORWARDJOIN, next, origin, 0, ttl - 1, 0, NULL);
+}
+
+/**
+ * FUNCTION NAME: viewAddActive
+ *
+ * DESCRIPTION: Make key an active peer. A full active view gives up a random peer,
+ * 				which is told with a DISCONNECT and kept as a passive one.
+ */
+void MP1Node::viewAddActive(uint64_t key) {
+    if (key == MemberTable::pack(&memberNode->addr) || view.isActive(key)) {
+        return;
+    }
+    if (view.activeFull()) {
+        uint64_t victim = view.randomActive(&random, 0);
+        view.removeActive(victim);
+        view.addPassive(victim, &random);
+        sendView(DISCONNECT, victim, 0, 0, 0, 0, NULL);
+    }
+    view.addActive(key, par->getcurrtime());
+    viewLearn(key);
+}
+
+/**
+ * FUNCTION NAME: viewLearn
+ *
+ * DESCRIPTION: Put key on the membership list if it is not there. Under the partial
+ * 				view the list holds this node, the peers it has had in its active view
+ * 				and not seen fail, and on the introducer the last census; moves
+ * 				between the views leave it alone.
+ */
+void MP1Node::viewLearn(uint64_t key) {
+    if (members.find(key) >= 0) {
+        return;
+    }
+    insertMember(MemberTable::keyid(key), MemberTable::keyport(key), 0);
+
+    Address node_addr;
+    MemberTable::unpack(key, &node_addr);
+    log->logNodeAdd(&memberNode->addr, &node_addr);
+}
+
+/**
+ * FUNCTION NAME: requestMemberList
+ *
+ * DESCRIPTION: Start rebuilding the full membership list under the partial view.
+ * 				A LISTREQ floods the active views and every node reached answers the
+ * 				requester, which collects the answers for VIEW_CENSUS_WINDOW ticks
+ * 				and then rebuilds its list from them in rebuildMemberList.
+ */
+void MP1Node::requestMemberList() {
+    uint64_t self = MemberTable::pack(&memberNode->addr);
+    censusKeys.clear();
+    censusAt = par->getcurrtime();
+    viewCensus(self, self, ++censusSeq);
+}
+
+/**
+ * FUNCTION NAME: rebuildMemberList
+ *
+ * DESCRIPTION: End the census under way: the membership list becomes this node, the
+ * 				members that answered and the ones learnt meanwhile. Members it did
+ * 				not reach are declared failed and the ones it found are learnt, so
+ * 				the log follows the list.
+ */
+void MP1Node::rebuildMemberList() {
+    censusKeys.push_back(MemberTable::pack(&memberNode->addr));
+    // members learnt since the census began may have joined after it passed
+    for (int index = 0; index < members.size(); index++) {
+        if (members.gettimestamp(index) >= censusAt) {
+            censusKeys.push_back(members.getkey(index));
+        }
+    }
+    sort(censusKeys.begin(), censusKeys.end());
+    censusKeys.erase(unique(censusKeys.begin(), censusKeys.end()), censusKeys.end());
+
+    Address node_addr;
+    for (int index = 0; index < members.size(); index++) {
+        if (!binary_search(censusKeys.begin(), censusKeys.end(), members.getkey(index))) {
+            MemberTable::unpack(members.getkey(index), &node_addr);
             log->logNodeRemove(&memberNode->addr, &node_addr);
-            
-            it->setid(0);
-            --neighbors;
-        } else if (it->gettimestamp() < par->getcurrtime() - TFAIL) {
-            ++failed;
         }
     }
-    
-    sendGossip();
-    return;
+    for (size_t i = 0; i < censusKeys.size(); i++) {
+        if (members.find(censusKeys[i]) < 0) {
+            MemberTable::unpack(censusKeys[i], &node_addr);
+            log->logNodeAdd(&memberNode->addr, &node_addr);
+        }
+    }
+
+    clearMembers();
+    for (size_t i = 0; i < censusKeys.size(); i++) {
+        insertMember(MemberTable::keyid(censusKeys[i]), MemberTable::keyport(censusKeys[i]), 0);
+    }
+    censusKeys.clear();
+    censusAt = -1;
+}
+
+/**
+ * FUNCTION NAME: viewCensus
+ *
+ * DESCRIPTION: Pass on the census seq of origin to the active peers but from, and
+ * 				answer origin. Recently seen censuses are ignored, which ends the flood.
+ */
+void MP1Node::viewCensus(uint64_t from, uint64_t origin, int seq) {
+    // addresses take 48 bits, the sequence number the rest
+    uint64_t id = origin ^ ((uint64_t)seq << 48);
+    if (find(censusSeen.begin(), censusSeen.end(), id) != censusSeen.end()) {
+        return;
+    }
+    if (censusSeen.size() < VIEW_CENSUS_SEEN) {
+        censusSeen.push_back(id);
+    } else {
+        censusSeen[censusNext++ % VIEW_CENSUS_SEEN] = id;
+    }
+
+    sendViewMulti(LISTREQ, from, origin, 0, seq);
+    if (origin != MemberTable::pack(&memberNode->addr)) {
+        sendView(LISTREP, origin, 0, 0, 0, seq, NULL);
+    }
+}
+
+/**
+ * FUNCTION NAME: sendView
+ *
+ * DESCRIPTION: Send a partial view message to to, carrying peers if not NULL
+ */
+void MP1Node::sendView(enum MsgTypes msgType, uint64_t to, uint64_t origin, int flag, int ttl, int seq, vector<uint64_t> *peers) {
+    Address toAddr, originAddr;
+    MemberTable::unpack(to, &toAddr);
+    MemberTable::unpack(origin, &originAddr);
+    ViewEncoder enc(&viewBuf, msgType, memberNode->addr.addr, originAddr.addr, flag, ttl, seq);
+    for (size_t i = 0; peers != NULL && i < peers->size(); i++) {
+        Address peer;
+        MemberTable::unpack((*peers)[i], &peer);
+        enc.add(peer.addr);
+    }
+    int size = enc.finish();
+    emulNet->ENsend(&memberNode->addr, &toAddr, viewBuf.data(), size);
+}
+
+/**
+ * FUNCTION NAME: sendViewMulti
+ *
+ * DESCRIPTION: Send one partial view message to every active peer but except
+ */
+void MP1Node::sendViewMulti(enum MsgTypes msgType, uint64_t except, uint64_t origin, int ttl, int seq) {
+    viewTargets.clear();
+    for (int i = 0; i < view.activeSize(); i++) {
+        if (view.getActive(i) != except) {
+            Address peer;
+            MemberTable::unpack(view.getActive(i), &peer);
+            viewTargets.push_back(peer);
+        }
+    }
+    if (viewTargets.empty()) {
+        return;
+    }
+    Address originAddr;
+    MemberTable::unpack(origin, &originAddr);
+    ViewEncoder enc(&viewBuf, msgType, memberNode->addr.addr, originAddr.addr, 0, ttl, seq);
+    int size = enc.finish();
+    Payload *payload = Payload::create(viewBuf.data(), size);
+    emulNet->ENsendMulti(&memberNode->addr, viewTargets.data(), viewTargets.size(), payload);
+    payload->release();
 }
 
 /**
@@ -468,6 +1489,7 @@ Address MP1Node::getJoinAddress() {
  * DESCRIPTION: Initialize the membership list
  */
 void MP1Node::initMemberListTable(Member *memberNode) {
+	clearMembers();
 	memberNode->memberList.clear();
 }
 
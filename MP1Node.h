@@ -8,13 +8,18 @@
 #ifndef _MP1NODE_H_
 #define _MP1NODE_H_
 
-#include <sstream>
 #include "stdincludes.h"
 #include "Log.h"
 #include "Params.h"
 #include "Member.h"
-#include "EmulNet.h"
+#include "Transport.h"
 #include "Queue.h"
+#include "Message.h"
+#include "TimerWheel.h"
+#include "MemberTable.h"
+#include "PiggybackQueue.h"
+#include "PartialView.h"
+#include "Random.h"
 
 /**
  * Macros
@@ -22,29 +27,75 @@
 #define TREMOVE 20
 #define TFAIL 5
 #define GOSSIP_CNT 4
+// Delta gossip: entries changed in the last DELTA_WINDOW ticks are sent,
+// and the whole list every FULL_SYNC_PERIOD ticks
+#define DELTA_WINDOW 1
+#define FULL_SYNC_PERIOD 10
+// Ticks the parts of a membership list are waited for once the first one arrived
+#define LIST_ASSEMBLY_TIMEOUT 2
+// SWIM detector: ticks a PING waits for its ACK before SWIM_PING_REQS other members
+// are asked to probe, ticks before the unanswered target is suspected, ticks a
+// suspect has to refute before it is declared dead, and ticks a dead member is
+// remembered so that stale updates cannot bring it back
+#define SWIM_ACK_TIMEOUT 2
+#define SWIM_PROBE_TIMEOUT 5
+#define SWIM_PING_REQS 3
+#define SWIM_SUSPECT_TIMEOUT 10
+#define SWIM_DEAD_TIMEOUT 40
+// Updates waiting to be piggybacked, and the factor of log2(N) giving how many
+// times each one is sent
+#define SWIM_QUEUE_CAPACITY 512
+#define SWIM_LAMBDA 3
+// Partial view: active view of log2(N) + VIEW_ACTIVE_EXTRA peers and a passive view
+// VIEW_PASSIVE_FACTOR times larger; steps of the join and shuffle random walks, and
+// the step at which a walk leaves the joining node in the passive view
+#define VIEW_ACTIVE_EXTRA 1
+#define VIEW_PASSIVE_FACTOR 6
+#define VIEW_ACTIVE_WALK 6
+#define VIEW_PASSIVE_WALK 3
+// Ticks between shuffles, and peers of each view a shuffle carries
+#define VIEW_SHUFFLE_PERIOD 10
+#define VIEW_SHUFFLE_ACTIVE 3
+#define VIEW_SHUFFLE_PASSIVE 4
+// Rounds of keepalives an active peer may miss before it is declared failed, ticks
+// a NEIGHBOR request waits for its answer, and census floods remembered
+#define VIEW_KEEPALIVE_MISSES 3
+#define VIEW_NEIGHBOR_TIMEOUT 2
+#define VIEW_CENSUS_SEEN 64
+// The introducer rebuilds its membership list by census every VIEW_CENSUS_PERIOD
+// ticks, from the answers that come within VIEW_CENSUS_WINDOW ticks
+#define VIEW_CENSUS_PERIOD 100
+#define VIEW_CENSUS_WINDOW 20
 
 /*
  * Note: You can change/add any functions in MP1Node.{h,cpp}
  */
 
 /**
- * Message Types
+ * STRUCT NAME: SwimProbe
+ *
+ * DESCRIPTION: PING waiting for its ACK
  */
-enum MsgTypes{
-    JOINREQ,
-    JOINREP,
-    GOSSIP,
-    DUMMYLASTMSGTYPE
-};
+typedef struct SwimProbe {
+	int seq;
+	uint64_t target;
+	int sentAt;
+	// PING_REQs have been sent
+	bool indirect;
+}SwimProbe;
 
 /**
- * STRUCT NAME: MessageHdr
+ * STRUCT NAME: ListAssembly
  *
- * DESCRIPTION: Header and content of a message
+ * DESCRIPTION: Parts received of a membership list sent in several messages
  */
-typedef struct MessageHdr {
-	enum MsgTypes msgType;
-}MessageHdr;
+typedef struct ListAssembly {
+	uint64_t from;
+	int snapshot;
+	int startedAt;
+	int received;
+	vector<bool> have;
+}ListAssembly;
 
 /**
  * CLASS NAME: MP1Node
@@ -53,20 +104,110 @@ typedef struct MessageHdr {
  */
 class MP1Node {
 private:
-	EmulNet *emulNet;
+	Transport *emulNet;
 	Log *log;
 	Params *par;
 	Member *memberNode;
 	char NULLADDR[6];
-	unsigned int neighbors = 0;
-	unsigned int failed = 0;
+	// Serialized membership lists shared by all messages of a tick, one payload per
+	// part when they do not fit in one message
+	vector<Payload *> listSnapshot;
+	vector<Payload *> deltaSnapshot;
+	int deltaSnapshotTime = -1;
+	bool listChanged = true;
+	int snapshotSeq = 0;
+	vector<char> snapshotBuf;
+	ListScratch listScratch;
+	// Multi-part lists being received, at most one per sender
+	vector<ListAssembly> assemblies;
+	vector<Address> pendingJoinReplies;
+	// Recipients of the current gossip round
+	vector<Address> gossipTargets;
+	// Membership list, memberNode->memberList is only a copy made by syncMemberList
+	MemberTable members;
+	// Rows picked by the last encodeMemberList
+	vector<int> selected;
+	// Table rows of the members neither suspected nor removed, in no particular
+	// order, and the position of each member in it (-1 if absent), by table row
+	vector<int> live;
+	vector<int> livePos;
+	// Failure and removal deadlines of the members, keyed by packed address (negated
+	// for removal)
+	TimerWheel expiryWheel;
+	vector<TimerItem> dueTimers;
+	Random random;
+	// SWIM detector
+	int incarnation = 0;
+	int probeSeq = 0;
+	size_t probeNext = 0;
+	vector<SwimProbe> probes;
+	PiggybackQueue rumors;
+	vector<char> swimBuf;
+	vector<int> helpers;
+	// Partial view
+	PartialView view;
+	size_t keepaliveNext = 0;
+	// passive peer asked to join the active view, 0 if none
+	uint64_t viewPending = 0;
+	int viewPendingAt = 0;
+	int censusSeq = 0;
+	// tick the census under way was sent, -1 if none, and the members that answered
+	int censusAt = -1;
+	vector<uint64_t> censusKeys;
+	vector<uint64_t> censusSeen;
+	size_t censusNext = 0;
+	vector<uint64_t> viewPeers;
+	vector<Address> viewTargets;
+	vector<char> viewBuf;
 	
 	void addNodeToMemberList(int, short, long);
+	int insertMember(int id, short port, long heartbeat);
+	void clearMembers();
+	void addLive(int index);
+	void removeLive(int index);
+	void removeMember(int index);
+	void swimLoopOps();
+	void swimExpire();
+	void swimCheckProbes();
+	void swimProbe();
+	bool swimRecv(enum MsgTypes msgType, char *data, int size);
+	void swimAlive(uint64_t key, int incarnation);
+	void swimSuspect(uint64_t key, int incarnation);
+	void swimConfirm(uint64_t key, int incarnation);
+	void swimDead(int index);
+	void swimRefute(int incarnation);
+	void addRumor(uint64_t key, int state, int incarnation);
+	int rumorLimit();
+	void sendSwim(enum MsgTypes msgType, Address *to, int seq, Address *origin, Address *target);
+	void viewLoopOps();
+	void viewExpire();
+	void viewRepair();
+	void viewShuffle();
+	bool viewRecv(enum MsgTypes msgType, char *data, int size);
+	void viewJoin(uint64_t key);
+	void viewForwardJoin(uint64_t from, uint64_t origin, int ttl);
+	void viewAddActive(uint64_t key);
+	void viewLearn(uint64_t key);
+	void rebuildMemberList();
+	void viewCensus(uint64_t from, uint64_t origin, int seq);
+	void sendView(enum MsgTypes msgType, uint64_t to, uint64_t origin, int flag, int ttl, int seq, vector<uint64_t> *peers);
+	void sendViewMulti(enum MsgTypes msgType, uint64_t except, uint64_t origin, int ttl, int seq);
+	void expireMembers();
+	void encodeMemberList(enum MsgTypes msgType, long since, vector<Payload *> *parts);
+	vector<Payload *> *getListSnapshot();
+	vector<Payload *> *getDeltaSnapshot();
+	void assembleList(ListDecoder *dec);
 	int getAddressId(Address* node);
 	short getAddressPort(Address* node);
 
 public:
-	MP1Node(Member *, Params *, EmulNet *, Log *, Address *);
+	MP1Node(Member *, Params *, Transport *, Log *, Address *);
+	bool swimMode() {
+		return par->DETECTOR == SWIM_DETECTOR;
+	}
+	bool partialView() {
+		return par->VIEW == PARTIAL_VIEW;
+	}
 	Member * getMemberNode() {
 		return memberNode;
 	}
@@ -76,13 +217,15 @@ public:
 	int initThisNode(Address *joinaddr);
 	int introduceSelfToGroup(Address *joinAddress);
 	int finishUpThisNode();
+	void syncMemberList();
+	void requestMemberList();
 	void nodeLoop();
 	void checkMessages();
 	bool recvCallBack(void *env, char *data, int size);
 	
 	// Messages
-	void sendGossip();
-	void sendJoinReply(Address *node);
+	void sendGossip(vector<Payload *> *snapshot);
+	void sendJoinReply(Address *node, vector<Payload *> *snapshot);
 
 	// Message handlers
 	void recvJoinRequest(Address *node, long heartbeat);
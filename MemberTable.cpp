@@ -0,0 +1,232 @@
+/**********************************
+ * FILE NAME: MemberTable.cpp
+ *
+ * DESCRIPTION: Definition of the membership table
+ **********************************/
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+#include "MemberTable.h"
+
+// Slots of an empty table, a power of two
+#define MEMBERTABLE_MIN_SLOTS 16
+
+/**
+ * Constructor
+ */
+MemberTable::MemberTable() {
+	MemberSlot empty = { 0, -1 };
+	slots.assign(MEMBERTABLE_MIN_SLOTS, empty);
+	mask = MEMBERTABLE_MIN_SLOTS - 1;
+}
+
+/**
+ * FUNCTION NAME: probe
+ *
+ * DESCRIPTION: Slot holding key, or the empty slot where it would go
+ */
+int MemberTable::probe(uint64_t key) {
+	int i = home(key);
+	while ( slots[i].key != 0 && slots[i].key != key ) {
+		i = (i + 1) & mask;
+	}
+	return i;
+}
+
+/**
+ * FUNCTION NAME: grow
+ *
+ * DESCRIPTION: Double the slots and rehash the members
+ */
+void MemberTable::grow() {
+	MemberSlot empty = { 0, -1 };
+	slots.assign(slots.size() * 2, empty);
+	mask = slots.size() - 1;
+	for ( size_t i = 0; i < ids.size(); i++ ) {
+		int s = probe(getkey(i));
+		slots[s].key = getkey(i);
+		slots[s].index = i;
+	}
+}
+
+/**
+ * FUNCTION NAME: find
+ *
+ * DESCRIPTION: Row of the member with address key
+ *
+ * RETURNS:
+ * index, -1 if absent
+ */
+int MemberTable::find(uint64_t key) {
+	return slots[probe(key)].index;
+}
+
+/**
+ * FUNCTION NAME: insert
+ *
+ * DESCRIPTION: Append a member. Its address must not be there already.
+ *
+ * RETURNS:
+ * index of the new row
+ */
+int MemberTable::insert(int id, short port, int heartbeat, int timestamp) {
+	if ( (ids.size() + 1) * 2 > slots.size() ) {
+		grow();
+	}
+	uint64_t key = pack(id, port);
+	int s = probe(key);
+	slots[s].key = key;
+	slots[s].index = ids.size();
+	ids.push_back(id);
+	ports.push_back(port);
+	heartbeats.push_back(heartbeat);
+	timestamps.push_back(timestamp);
+	states.push_back(MEMBER_ALIVE);
+	return slots[s].index;
+}
+
+/**
+ * FUNCTION NAME: erase
+ *
+ * DESCRIPTION: Remove the row at index, moving the last row into its place. The
+ * 				slot is emptied by shifting back the keys probed past it, so
+ * 				lookups never meet tombstones.
+ *
+ * RETURNS:
+ * former index of the row moved to index, -1 if none was
+ */
+int MemberTable::erase(int index) {
+	int i = probe(getkey(index));
+	int j = i;
+	while ( true ) {
+		j = (j + 1) & mask;
+		if ( slots[j].key == 0 ) {
+			break;
+		}
+		int k = home(slots[j].key);
+		// slot j may move to i unless its home lies cyclically in (i, j]
+		bool stays = (i <= j) ? (i < k && k <= j) : (i < k || k <= j);
+		if ( !stays ) {
+			slots[i] = slots[j];
+			i = j;
+		}
+	}
+	slots[i].key = 0;
+	slots[i].index = -1;
+
+	int last = ids.size() - 1;
+	int moved = -1;
+	if ( index != last ) {
+		slots[probe(getkey(last))].index = index;
+		ids[index] = ids[last];
+		ports[index] = ports[last];
+		heartbeats[index] = heartbeats[last];
+		timestamps[index] = timestamps[last];
+		states[index] = states[last];
+		moved = last;
+	}
+	ids.pop_back();
+	ports.pop_back();
+	heartbeats.pop_back();
+	timestamps.pop_back();
+	states.pop_back();
+	return moved;
+}
+
+/**
+ * FUNCTION NAME: clear
+ *
+ * DESCRIPTION: Remove every member
+ */
+void MemberTable::clear() {
+	MemberSlot empty = { 0, -1 };
+	ids.clear();
+	ports.clear();
+	heartbeats.clear();
+	timestamps.clear();
+	states.clear();
+	slots.assign(MEMBERTABLE_MIN_SLOTS, empty);
+	mask = MEMBERTABLE_MIN_SLOTS - 1;
+}
+
+#if defined(__x86_64__)
+/**
+ * FUNCTION NAME: selectSinceAvx2
+ *
+ * DESCRIPTION: selectSince eight timestamps at a time, from row first on
+ *
+ * RETURNS:
+ * first row left for the caller
+ */
+__attribute__((target("avx2")))
+static int selectSinceAvx2(const int32_t *ts, int n, int since, vector<int> *out) {
+	__m256i floor = _mm256_set1_epi32(since - 1);
+	int i = 0;
+	for ( ; i + 8 <= n; i += 8 ) {
+		__m256i t = _mm256_loadu_si256((const __m256i *)(ts + i));
+		int bits = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(t, floor)));
+		while ( bits ) {
+			out->push_back(i + __builtin_ctz(bits));
+			bits &= bits - 1;
+		}
+	}
+	return i;
+}
+
+/**
+ * FUNCTION NAME: selectSinceSse2
+ *
+ * DESCRIPTION: selectSince four timestamps at a time
+ *
+ * RETURNS:
+ * first row left for the caller
+ */
+static int selectSinceSse2(const int32_t *ts, int n, int since, vector<int> *out) {
+	__m128i floor = _mm_set1_epi32(since - 1);
+	int i = 0;
+	for ( ; i + 4 <= n; i += 4 ) {
+		__m128i t = _mm_loadu_si128((const __m128i *)(ts + i));
+		int bits = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(t, floor)));
+		while ( bits ) {
+			out->push_back(i + __builtin_ctz(bits));
+			bits &= bits - 1;
+		}
+	}
+	return i;
+}
+#endif
+
+/**
+ * FUNCTION NAME: selectSince
+ *
+ * DESCRIPTION: Append to out, in row order, the rows whose timestamp is at least since.
+ * 				The timestamp column is compared a vector at a time.
+ */
+void MemberTable::selectSince(int since, vector<int> *out) {
+	const int32_t *ts = timestamps.data();
+	int n = timestamps.size();
+	int i = 0;
+#if defined(__x86_64__)
+	static const bool avx2 = __builtin_cpu_supports("avx2");
+	i = avx2 ? selectSinceAvx2(ts, n, since, out) : selectSinceSse2(ts, n, since, out);
+#endif
+	for ( ; i < n; i++ ) {
+		if ( ts[i] >= since ) {
+			out->push_back(i);
+		}
+	}
+}
+
+/**
+ * FUNCTION NAME: copyTo
+ *
+ * DESCRIPTION: Fill list with the MemberListEntry view of every row, in row order
+ */
+void MemberTable::copyTo(vector<MemberListEntry> *list) {
+	list->clear();
+	list->reserve(ids.size());
+	for ( size_t i = 0; i < ids.size(); i++ ) {
+		list->push_back(entry(i));
+	}
+}
@@ -0,0 +1,120 @@
+/**********************************
+ * FILE NAME: MemberTable.h
+ *
+ * DESCRIPTION: Header file of the membership table
+ **********************************/
+
+#ifndef _MEMBERTABLE_H_
+#define _MEMBERTABLE_H_
+
+#include <stdint.h>
+#include "stdincludes.h"
+#include "Member.h"
+
+/**
+ * State of a member, only the SWIM detector suspects members and keeps dead ones
+ */
+enum MemberStates {
+	MEMBER_ALIVE,
+	MEMBER_SUSPECT,
+	MEMBER_DEAD
+};
+
+/**
+ * STRUCT NAME: MemberSlot
+ *
+ * DESCRIPTION: Slot of the hash table: packed address of a member and its position in
+ * 				the columns. key 0 marks an empty slot, no member has id 0.
+ */
+typedef struct MemberSlot {
+	uint64_t key;
+	int index;
+}MemberSlot;
+
+/**
+ * CLASS NAME: MemberTable
+ *
+ * DESCRIPTION: Membership list stored as one column per field, with ticks in 32 bits,
+ * 				and indexed by an open-addressing hash table keyed by the packed 6-byte
+ * 				address of each member. The columns stay dense: removing a member moves
+ * 				the last one into its place, so scans only touch present members and
+ * 				memory follows the member count, not the largest id. entry() and
+ * 				copyTo() give the MemberListEntry view of the rows.
+ */
+class MemberTable {
+private:
+	vector<int32_t> ids;
+	vector<int16_t> ports;
+	vector<int32_t> heartbeats;
+	vector<int32_t> timestamps;
+	vector<uint8_t> states;
+	// linear probing, at most half full
+	vector<MemberSlot> slots;
+	int mask;
+	int home(uint64_t key) {
+		// Fibonacci hashing: ids are small and consecutive, spread them
+		return (int)((key * 0x9E3779B97F4A7C15ULL) >> 32) & mask;
+	}
+	int probe(uint64_t key);
+	void grow();
+public:
+	MemberTable();
+	static uint64_t pack(int id, short port) {
+		return (uint32_t)id | ((uint64_t)(uint16_t)port << 32);
+	}
+	static uint64_t pack(Address *addr) {
+		uint64_t key = 0;
+		memcpy(&key, addr->addr, sizeof(addr->addr));
+		return key;
+	}
+	static void unpack(uint64_t key, Address *addr) {
+		memcpy(addr->addr, &key, sizeof(addr->addr));
+	}
+	static int keyid(uint64_t key) {
+		return (int32_t)key;
+	}
+	static short keyport(uint64_t key) {
+		return (int16_t)(key >> 32);
+	}
+	int size() {
+		return ids.size();
+	}
+	uint64_t getkey(int index) {
+		return pack(ids[index], ports[index]);
+	}
+	int getid(int index) {
+		return ids[index];
+	}
+	short getport(int index) {
+		return ports[index];
+	}
+	int getheartbeat(int index) {
+		return heartbeats[index];
+	}
+	int gettimestamp(int index) {
+		return timestamps[index];
+	}
+	void setheartbeat(int index, int heartbeat) {
+		heartbeats[index] = heartbeat;
+	}
+	void settimestamp(int index, int timestamp) {
+		timestamps[index] = timestamp;
+	}
+	int getstate(int index) {
+		return states[index];
+	}
+	void setstate(int index, int state) {
+		states[index] = state;
+	}
+	MemberListEntry entry(int index) {
+		return MemberListEntry(ids[index], ports[index], heartbeats[index], timestamps[index]);
+	}
+	int find(uint64_t key);
+	int insert(int id, short port, int heartbeat, int timestamp);
+	int erase(int index);
+	void clear();
+	void selectSince(int since, vector<int> *out);
+	void copyTo(vector<MemberListEntry> *list);
+};
+
+#endif /* _MEMBERTABLE_H_ */
@@ -0,0 +1,332 @@
+/**********************************
+ * FILE NAME: Message.cpp
+ *
+ * DESCRIPTION: Binary wire format of membership lists
+ **********************************/
+
+#if defined(__x86_64__)
+#include <emmintrin.h>
+#endif
+#include "Message.h"
+
+/**
+ * Constructor
+ */
+ListEncoder::ListEncoder(vector<char> *buf, enum MsgTypes msgType, int codec, const char *from, int snapshot, int part, int parts):
+	buf(buf), count(0), codec(codec), prevId(0), prevPort(0), prevHeartbeat(0) {
+	ListMsgHdr hdr;
+	memset(&hdr, 0, sizeof(ListMsgHdr));
+	hdr.hdr.msgType = msgType;
+	hdr.version = WIRE_VERSION;
+	hdr.codec = codec;
+	hdr.part = part;
+	hdr.parts = parts;
+	memcpy(hdr.from, from, sizeof(hdr.from));
+	hdr.snapshot = snapshot;
+	buf->resize(sizeof(ListMsgHdr));
+	memcpy(buf->data(), &hdr, sizeof(ListMsgHdr));
+}
+
+/**
+ * FUNCTION NAME: zigzag
+ *
+ * DESCRIPTION: Map a signed delta to an unsigned one, small either way
+ */
+static uint64_t zigzag(uint64_t delta) {
+	return (delta << 1) ^ (uint64_t)((int64_t)delta >> 63);
+}
+
+/**
+ * FUNCTION NAME: unzigzag
+ *
+ * DESCRIPTION: Inverse of zigzag
+ */
+static uint64_t unzigzag(uint64_t value) {
+	return (value >> 1) ^ (0 - (value & 1));
+}
+
+/**
+ * FUNCTION NAME: putVarint
+ *
+ * DESCRIPTION: Append value as a LEB128 varint, seven bits per byte, low bits first
+ */
+void ListEncoder::putVarint(uint64_t value) {
+	while ( value >= 0x80 ) {
+		buf->push_back((char)(value | 0x80));
+		value >>= 7;
+	}
+	buf->push_back((char)value);
+}
+
+/**
+ * FUNCTION NAME: add
+ *
+ * DESCRIPTION: Append one entry to the message
+ */
+void ListEncoder::add(int id, short port, long heartbeat) {
+	if ( codec == VARINT_CODEC ) {
+		bool portChanged = port != prevPort;
+		putVarint((((uint64_t)((int64_t)id - prevId)) << 1) | portChanged);
+		if ( portChanged ) {
+			putVarint(zigzag((uint64_t)(int64_t)port - (uint64_t)(int64_t)prevPort));
+		}
+		putVarint(zigzag((uint64_t)heartbeat - (uint64_t)prevHeartbeat));
+		prevId = id;
+		prevPort = port;
+		prevHeartbeat = heartbeat;
+		count++;
+		return;
+	}
+
+	WireEntry entry;
+	entry.id = id;
+	entry.port = port;
+	entry.heartbeat = heartbeat;
+	size_t offset = buf->size();
+	buf->resize(offset + sizeof(WireEntry));
+	memcpy(buf->data() + offset, &entry, sizeof(WireEntry));
+	count++;
+}
+
+/**
+ * FUNCTION NAME: finish
+ *
+ * DESCRIPTION: Write the entry count into the header
+ *
+ * RETURNS:
+ * size of the encoded message
+ */
+int ListEncoder::finish() {
+	int32_t c = count;
+	memcpy(buf->data() + offsetof(ListMsgHdr, count), &c, sizeof(int32_t));
+	return buf->size();
+}
+
+/**
+ * FUNCTION NAME: setParts
+ *
+ * DESCRIPTION: Set the number of parts of a finished message, once it is known
+ */
+void ListEncoder::setParts(char *data, int parts) {
+	uint16_t p = parts;
+	memcpy(data + offsetof(ListMsgHdr, parts), &p, sizeof(uint16_t));
+}
+
+/**
+ * FUNCTION NAME: getVarints
+ *
+ * DESCRIPTION: Append to out every LEB128 varint from p to end. Sixteen bytes
+ * 				without a continuation bit are sixteen one-byte values, widened
+ * 				together; deltas of a dense sorted list are mostly such bytes.
+ *
+ * RETURNS:
+ * false if the last varint is cut short or longer than 64 bits
+ */
+static bool getVarints(const uint8_t *p, const uint8_t *end, vector<uint64_t> *out) {
+	out->clear();
+	while ( p < end ) {
+#if defined(__x86_64__)
+		if ( end - p >= 16 ) {
+			__m128i bytes = _mm_loadu_si128((const __m128i *)p);
+			if ( _mm_movemask_epi8(bytes) == 0 ) {
+				__m128i zero = _mm_setzero_si128();
+				__m128i half[2] = { _mm_unpacklo_epi8(bytes, zero), _mm_unpackhi_epi8(bytes, zero) };
+				size_t n = out->size();
+				out->resize(n + 16);
+				__m128i *dst = (__m128i *)(out->data() + n);
+				for ( int h = 0; h < 2; h++ ) {
+					__m128i lo = _mm_unpacklo_epi16(half[h], zero);
+					__m128i hi = _mm_unpackhi_epi16(half[h], zero);
+					_mm_storeu_si128(dst++, _mm_unpacklo_epi32(lo, zero));
+					_mm_storeu_si128(dst++, _mm_unpackhi_epi32(lo, zero));
+					_mm_storeu_si128(dst++, _mm_unpacklo_epi32(hi, zero));
+					_mm_storeu_si128(dst++, _mm_unpackhi_epi32(hi, zero));
+				}
+				p += 16;
+				continue;
+			}
+		}
+#endif
+		uint64_t value = 0;
+		int shift = 0;
+		uint8_t b;
+		do {
+			if ( p == end || shift > 63 ) {
+				return false;
+			}
+			b = *p++;
+			value |= (uint64_t)(b & 0x7f) << shift;
+			shift += 7;
+		} while ( b & 0x80 );
+		out->push_back(value);
+	}
+	return true;
+}
+
+/**
+ * FUNCTION NAME: unpack
+ *
+ * DESCRIPTION: Decode the VARINT_CODEC entries following the header into scratch
+ *
+ * RETURNS:
+ * false if they do not make exactly count entries
+ */
+bool ListDecoder::unpack(const char *data, int size, ListScratch *scratch) {
+	const uint8_t *p = (const uint8_t *)data + sizeof(ListMsgHdr);
+	if ( !getVarints(p, (const uint8_t *)data + size, &scratch->values) ) {
+		return false;
+	}
+	const vector<uint64_t> &v = scratch->values;
+	size_t k = 0;
+	uint64_t id = 0, port = 0, heartbeat = 0;
+	scratch->entries.resize(hdr->count);
+	for ( int i = 0; i < hdr->count; i++ ) {
+		if ( k + 2 > v.size() ) {
+			return false;
+		}
+		uint64_t first = v[k++];
+		id += first >> 1;
+		if ( first & 1 ) {
+			port += unzigzag(v[k++]);
+			if ( k == v.size() ) {
+				return false;
+			}
+		}
+		heartbeat += unzigzag(v[k++]);
+		WireEntry &e = scratch->entries[i];
+		e.id = (int32_t)id;
+		e.port = (int16_t)port;
+		e.heartbeat = (int64_t)heartbeat;
+	}
+	entries = scratch->entries.data();
+	return k == v.size();
+}
+
+/**
+ * Constructor
+ */
+ListDecoder::ListDecoder(const char *data, int size, ListScratch *scratch) {
+	hdr = reinterpret_cast<const ListMsgHdr *>(data);
+	entries = reinterpret_cast<const WireEntry *>(data + sizeof(ListMsgHdr));
+	ok = size >= (int)sizeof(ListMsgHdr)
+		&& hdr->version == WIRE_VERSION
+		&& hdr->part < hdr->parts
+		&& hdr->count >= 0;
+	if ( !ok ) {
+		return;
+	}
+	if ( hdr->codec == VARINT_CODEC ) {
+		ok = scratch != NULL && hdr->count <= size && unpack(data, size, scratch);
+	}
+	else {
+		ok = hdr->codec == FIXED_CODEC
+			&& size - (int)sizeof(ListMsgHdr) == (int64_t)hdr->count * (int64_t)sizeof(WireEntry);
+	}
+}
+
+/**
+ * Constructor
+ */
+SwimEncoder::SwimEncoder(vector<char> *buf, enum MsgTypes msgType, int seq, int incarnation, const char *from, const char *origin, const char *target): buf(buf), count(0) {
+	SwimMsgHdr hdr;
+	memset(&hdr, 0, sizeof(SwimMsgHdr));
+	hdr.hdr.msgType = msgType;
+	hdr.version = WIRE_VERSION;
+	hdr.seq = seq;
+	hdr.incarnation = incarnation;
+	memcpy(hdr.from, from, sizeof(hdr.from));
+	memcpy(hdr.origin, origin, sizeof(hdr.origin));
+	memcpy(hdr.target, target, sizeof(hdr.target));
+	buf->resize(sizeof(SwimMsgHdr));
+	memcpy(buf->data(), &hdr, sizeof(SwimMsgHdr));
+}
+
+/**
+ * FUNCTION NAME: add
+ *
+ * DESCRIPTION: Append one update to the message
+ */
+void SwimEncoder::add(const SwimUpdate &update) {
+	size_t offset = buf->size();
+	buf->resize(offset + sizeof(SwimUpdate));
+	memcpy(buf->data() + offset, &update, sizeof(SwimUpdate));
+	count++;
+}
+
+/**
+ * FUNCTION NAME: finish
+ *
+ * DESCRIPTION: Write the update count into the header
+ *
+ * RETURNS:
+ * size of the encoded message
+ */
+int SwimEncoder::finish() {
+	int32_t c = count;
+	memcpy(buf->data() + offsetof(SwimMsgHdr, count), &c, sizeof(int32_t));
+	return buf->size();
+}
+
+/**
+ * Constructor
+ */
+SwimDecoder::SwimDecoder(const char *data, int size) {
+	hdr = reinterpret_cast<const SwimMsgHdr *>(data);
+	updates = reinterpret_cast<const SwimUpdate *>(data + sizeof(SwimMsgHdr));
+	ok = size >= (int)sizeof(SwimMsgHdr)
+		&& hdr->version == WIRE_VERSION
+		&& hdr->count >= 0
+		&& size - (int)sizeof(SwimMsgHdr) == (int64_t)hdr->count * (int64_t)sizeof(SwimUpdate);
+}
+
+/**
+ * Constructor
+ */
+ViewEncoder::ViewEncoder(vector<char> *buf, enum MsgTypes msgType, const char *from, const char *origin, int flag, int ttl, int seq): buf(buf), count(0) {
+	ViewMsgHdr hdr;
+	memset(&hdr, 0, sizeof(ViewMsgHdr));
+	hdr.hdr.msgType = msgType;
+	hdr.version = WIRE_VERSION;
+	hdr.flag = flag;
+	hdr.ttl = ttl;
+	memcpy(hdr.from, from, sizeof(hdr.from));
+	memcpy(hdr.origin, origin, sizeof(hdr.origin));
+	hdr.seq = seq;
+	buf->resize(sizeof(ViewMsgHdr));
+	memcpy(buf->data(), &hdr, sizeof(ViewMsgHdr));
+}
+
+/**
+ * FUNCTION NAME: add
+ *
+ * DESCRIPTION: Append one address to the message
+ */
+void ViewEncoder::add(const char *addr) {
+	buf->insert(buf->end(), addr, addr + 6);
+	count++;
+}
+
+/**
+ * FUNCTION NAME: finish
+ *
+ * DESCRIPTION: Write the address count into the header
+ *
+ * RETURNS:
+ * size of the encoded message
+ */
+int ViewEncoder::finish() {
+	uint8_t c = count;
+	memcpy(buf->data() + offsetof(ViewMsgHdr, count), &c, sizeof(uint8_t));
+	return buf->size();
+}
+
+/**
+ * Constructor
+ */
+ViewDecoder::ViewDecoder(const char *data, int size) {
+	hdr = reinterpret_cast<const ViewMsgHdr *>(data);
+	peers = data + sizeof(ViewMsgHdr);
+	ok = size >= (int)sizeof(ViewMsgHdr)
+		&& hdr->version == WIRE_VERSION
+		&& size - (int)sizeof(ViewMsgHdr) == hdr->count * 6;
+}
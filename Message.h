@@ -0,0 +1,318 @@
+/**********************************
+ * FILE NAME: Message.h
+ *
+ * DESCRIPTION: Message types and the binary wire format of membership lists
+ **********************************/
+
+#ifndef _MESSAGE_H_
+#define _MESSAGE_H_
+
+#include <stdint.h>
+#include "stdincludes.h"
+
+/*
+ * Macros
+ */
+// Bump whenever the layout of ListMsgHdr or WireEntry changes
+#define WIRE_VERSION 2
+// Most bytes one entry takes under VARINT_CODEC
+#define VARINT_ENTRY_MAX 18
+
+/**
+ * Message Types
+ */
+enum MsgTypes{
+    JOINREQ,
+    JOINREP,
+    GOSSIP,
+    PING,
+    ACK,
+    PING_REQ,
+    FORWARDJOIN,
+    NEIGHBOR,
+    NEIGHBOR_REP,
+    DISCONNECT,
+    SHUFFLE,
+    SHUFFLE_REP,
+    KEEPALIVE,
+    LISTREQ,
+    LISTREP,
+    DUMMYLASTMSGTYPE
+};
+
+/**
+ * Encodings of the entries of a membership list, sent in ListMsgHdr::codec
+ */
+enum ListCodecs{
+    // WireEntry records
+    FIXED_CODEC,
+    // entries sorted by id, each as LEB128 varints: the id delta shifted left by
+    // one, its low bit set when the port changes, then the zigzag port delta if it
+    // does, then the zigzag heartbeat delta
+    VARINT_CODEC
+};
+
+/**
+ * STRUCT NAME: MessageHdr
+ *
+ * DESCRIPTION: Header and content of a message
+ */
+typedef struct MessageHdr {
+	enum MsgTypes msgType;
+}MessageHdr;
+
+/**
+ * STRUCT NAME: ListMsgHdr
+ *
+ * DESCRIPTION: Header of a message carrying a membership list (JOINREP, GOSSIP).
+ * 				A list too big for one message is sent in parts, each numbered part
+ * 				of parts within the list numbered snapshot by its sender from. It is
+ * 				followed on the wire by count packed WireEntry records.
+ */
+typedef struct ListMsgHdr {
+	MessageHdr hdr;
+	uint8_t version;
+	uint8_t codec;
+	uint16_t part;
+	uint16_t parts;
+	char from[6];
+	int32_t snapshot;
+	int32_t count;
+}ListMsgHdr;
+
+/**
+ * STRUCT NAME: WireEntry
+ *
+ * DESCRIPTION: One membership list entry as laid out on the wire
+ */
+typedef struct __attribute__((packed)) WireEntry {
+	int32_t id;
+	int16_t port;
+	int64_t heartbeat;
+}WireEntry;
+
+/**
+ * Membership updates carried by SWIM messages
+ */
+enum SwimStates{
+    SWIM_ALIVE,
+    SWIM_SUSPECT,
+    SWIM_CONFIRM
+};
+
+/**
+ * STRUCT NAME: SwimMsgHdr
+ *
+ * DESCRIPTION: Header of a SWIM probe message (PING, ACK, PING_REQ). from is the
+ * 				sender, origin the node that started the probe and target the node
+ * 				probed. It is followed on the wire by count packed SwimUpdate records.
+ */
+typedef struct SwimMsgHdr {
+	MessageHdr hdr;
+	uint8_t version;
+	uint8_t reserved[3];
+	int32_t seq;
+	// incarnation of from
+	int32_t incarnation;
+	char from[6];
+	char origin[6];
+	char target[6];
+	char pad[2];
+	int32_t count;
+}SwimMsgHdr;
+
+/**
+ * STRUCT NAME: SwimUpdate
+ *
+ * DESCRIPTION: One piggybacked membership update as laid out on the wire
+ */
+typedef struct __attribute__((packed)) SwimUpdate {
+	int32_t id;
+	int16_t port;
+	uint8_t state;
+	int32_t incarnation;
+}SwimUpdate;
+
+/**
+ * STRUCT NAME: ViewMsgHdr
+ *
+ * DESCRIPTION: Header of a partial view message (FORWARDJOIN to LISTREP). from is the
+ * 				sender and origin the node a walk or flood started at. flag is the
+ * 				priority of a NEIGHBOR and the answer of a NEIGHBOR_REP. It is
+ * 				followed on the wire by count 6-byte addresses.
+ */
+typedef struct ViewMsgHdr {
+	MessageHdr hdr;
+	uint8_t version;
+	uint8_t flag;
+	uint8_t ttl;
+	uint8_t count;
+	char from[6];
+	char origin[6];
+	int32_t seq;
+}ViewMsgHdr;
+
+/**
+ * STRUCT NAME: ListScratch
+ *
+ * DESCRIPTION: Caller owned buffers a ListDecoder unpacks compressed lists into
+ */
+typedef struct ListScratch {
+	vector<uint64_t> values;
+	vector<WireEntry> entries;
+}ListScratch;
+
+/**
+ * CLASS NAME: ListEncoder
+ *
+ * DESCRIPTION: Builds a membership list message into a caller owned buffer. Under
+ * 				VARINT_CODEC the entries must be added in increasing (id, port) order.
+ */
+class ListEncoder {
+private:
+	vector<char> *buf;
+	int count;
+	int codec;
+	int prevId;
+	short prevPort;
+	long prevHeartbeat;
+	void putVarint(uint64_t value);
+public:
+	ListEncoder(vector<char> *buf, enum MsgTypes msgType, int codec, const char *from, int snapshot, int part, int parts);
+	void add(int id, short port, long heartbeat);
+	bool fits(int limit) {
+		return (int)buf->size() + (codec == VARINT_CODEC ? VARINT_ENTRY_MAX : (int)sizeof(WireEntry)) <= limit;
+	}
+	int finish();
+	static void setParts(char *data, int parts);
+};
+
+/**
+ * CLASS NAME: ListDecoder
+ *
+ * DESCRIPTION: Validates a membership list message and reads its entries, in place
+ * 				under FIXED_CODEC and from scratch under VARINT_CODEC
+ */
+class ListDecoder {
+private:
+	const ListMsgHdr *hdr;
+	const WireEntry *entries;
+	bool ok;
+	bool unpack(const char *data, int size, ListScratch *scratch);
+public:
+	ListDecoder(const char *data, int size, ListScratch *scratch);
+	bool valid() {
+		return ok;
+	}
+	enum MsgTypes getMsgType() {
+		return hdr->hdr.msgType;
+	}
+	int getCount() {
+		return ok ? hdr->count : 0;
+	}
+	int getPart() {
+		return hdr->part;
+	}
+	int getParts() {
+		return hdr->parts;
+	}
+	int getSnapshot() {
+		return hdr->snapshot;
+	}
+	const char *getFrom() {
+		return hdr->from;
+	}
+	int getid(int i) {
+		return entries[i].id;
+	}
+	short getport(int i) {
+		return entries[i].port;
+	}
+	long getheartbeat(int i) {
+		return entries[i].heartbeat;
+	}
+};
+
+/**
+ * CLASS NAME: SwimEncoder
+ *
+ * DESCRIPTION: Builds a SWIM message into a caller owned buffer
+ */
+class SwimEncoder {
+private:
+	vector<char> *buf;
+	int count;
+public:
+	SwimEncoder(vector<char> *buf, enum MsgTypes msgType, int seq, int incarnation, const char *from, const char *origin, const char *target);
+	void add(const SwimUpdate &update);
+	int finish();
+};
+
+/**
+ * CLASS NAME: SwimDecoder
+ *
+ * DESCRIPTION: Validates a SWIM message and reads it in place
+ */
+class SwimDecoder {
+private:
+	const SwimMsgHdr *hdr;
+	const SwimUpdate *updates;
+	bool ok;
+public:
+	SwimDecoder(const char *data, int size);
+	bool valid() {
+		return ok;
+	}
+	const SwimMsgHdr *getHdr() {
+		return hdr;
+	}
+	int getCount() {
+		return ok ? hdr->count : 0;
+	}
+	const SwimUpdate &getUpdate(int i) {
+		return updates[i];
+	}
+};
+
+/**
+ * CLASS NAME: ViewEncoder
+ *
+ * DESCRIPTION: Builds a partial view message into a caller owned buffer
+ */
+class ViewEncoder {
+private:
+	vector<char> *buf;
+	int count;
+public:
+	ViewEncoder(vector<char> *buf, enum MsgTypes msgType, const char *from, const char *origin, int flag, int ttl, int seq);
+	void add(const char *addr);
+	int finish();
+};
+
+/**
+ * CLASS NAME: ViewDecoder
+ *
+ * DESCRIPTION: Validates a partial view message and reads it in place
+ */
+class ViewDecoder {
+private:
+	const ViewMsgHdr *hdr;
+	const char *peers;
+	bool ok;
+public:
+	ViewDecoder(const char *data, int size);
+	bool valid() {
+		return ok;
+	}
+	const ViewMsgHdr *getHdr() {
+		return hdr;
+	}
+	int getCount() {
+		return ok ? hdr->count : 0;
+	}
+	const char *getPeer(int i) {
+		return peers + 6 * i;
+	}
+};
+
+#endif /* _MESSAGE_H_ */
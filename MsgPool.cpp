@@ -0,0 +1,93 @@
+/**********************************
+ * FILE NAME: MsgPool.cpp
+ *
+ * DESCRIPTION: Definition of the pooled allocator of message buffers
+ **********************************/
+
+#include "MsgPool.h"
+
+/*
+ * Every block starts with a header holding its size class (-1 for malloc'ed blocks),
+ * padded to 16 bytes to keep the memory handed out aligned.
+ */
+#define POOL_HEADER 16
+
+MsgPool::SizeClass MsgPool::classes[POOL_CLASSES];
+
+/**
+ * FUNCTION NAME: classOf
+ *
+ * DESCRIPTION: Smallest size class holding size bytes plus the header, -1 if none does
+ */
+int MsgPool::classOf(size_t size) {
+	size += POOL_HEADER;
+	for ( int cls = 0; cls < POOL_CLASSES; cls++ ) {
+		if ( size <= blockSize(cls) ) {
+			return cls;
+		}
+	}
+	return -1;
+}
+
+/**
+ * FUNCTION NAME: blockSize
+ *
+ * DESCRIPTION: Size of the blocks of a class, growing 4x from POOL_MIN_BLOCK
+ */
+size_t MsgPool::blockSize(int cls) {
+	return (size_t)POOL_MIN_BLOCK << (2 * cls);
+}
+
+/**
+ * FUNCTION NAME: alloc
+ *
+ * DESCRIPTION: Allocate size bytes
+ */
+void *MsgPool::alloc(size_t size) {
+	int cls = classOf(size);
+	char *block;
+
+	if ( cls < 0 ) {
+		block = (char *)malloc(POOL_HEADER + size);
+	}
+	else {
+		SizeClass &sc = classes[cls];
+		lock_guard<mutex> guard(sc.lock);
+		if ( sc.free == NULL ) {
+			size_t bsize = blockSize(cls);
+			char *slab = (char *)malloc(bsize * POOL_SLAB_BLOCKS);
+			sc.slabs.push_back(slab);
+			for ( int i = POOL_SLAB_BLOCKS - 1; i >= 0; i-- ) {
+				FreeBlock *fb = (FreeBlock *)(slab + i * bsize);
+				fb->next = sc.free;
+				sc.free = fb;
+			}
+		}
+		block = (char *)sc.free;
+		sc.free = sc.free->next;
+	}
+
+	*(int *)block = cls;
+	return block + POOL_HEADER;
+}
+
+/**
+ * FUNCTION NAME: release
+ *
+ * DESCRIPTION: Give back a block obtained from alloc
+ */
+void MsgPool::release(void *ptr) {
+	char *block = (char *)ptr - POOL_HEADER;
+	int cls = *(int *)block;
+
+	if ( cls < 0 ) {
+		free(block);
+		return;
+	}
+
+	SizeClass &sc = classes[cls];
+	lock_guard<mutex> guard(sc.lock);
+	FreeBlock *fb = (FreeBlock *)block;
+	fb->next = sc.free;
+	sc.free = fb;
+}
@@ -0,0 +1,49 @@
+/**********************************
+ * FILE NAME: MsgPool.h
+ *
+ * DESCRIPTION: Header file of the pooled allocator of message buffers
+ **********************************/
+
+#ifndef _MSGPOOL_H_
+#define _MSGPOOL_H_
+
+#include <mutex>
+#include "stdincludes.h"
+
+/*
+ * Macros
+ */
+// Block sizes of the size classes. The largest one holds a message of
+// Params::MAX_MSG_SIZE (4000 B) with its headers, anything bigger uses malloc.
+#define POOL_CLASSES 4
+#define POOL_MIN_BLOCK 64
+#define POOL_MAX_BLOCK 4096
+// Blocks carved from the heap at once when a size class runs dry
+#define POOL_SLAB_BLOCKS 32
+
+/**
+ * CLASS NAME: MsgPool
+ *
+ * DESCRIPTION: Slab allocator for en_msg headers and message payloads. Freed blocks go
+ * 				back to the free list of their size class and are reused, so once the
+ * 				pools are warm the message path does not touch the heap.
+ */
+class MsgPool {
+private:
+	struct FreeBlock {
+		FreeBlock *next;
+	};
+	struct SizeClass {
+		mutex lock;
+		FreeBlock *free;
+		vector<void *> slabs;
+	};
+	static SizeClass classes[POOL_CLASSES];
+	static int classOf(size_t size);
+	static size_t blockSize(int cls);
+public:
+	static void *alloc(size_t size);
+	static void release(void *ptr);
+};
+
+#endif /* _MSGPOOL_H_ */
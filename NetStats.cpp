@@ -0,0 +1,127 @@
+/**********************************
+ * FILE NAME: NetStats.cpp
+ *
+ * DESCRIPTION: Definition of the network message counters
+ **********************************/
+
+#include "NetStats.h"
+
+/**
+ * Constructor
+ *
+ * Room is made for ids 1 to nodes, more are added by addNode
+ */
+NetStats::NetStats(int nodes) {
+	addNode(nodes);
+}
+
+/**
+ * FUNCTION NAME: addNode
+ *
+ * DESCRIPTION: Make sure counters exist for node id. Not safe to call while other
+ * 				threads are counting.
+ */
+void NetStats::addNode(int id) {
+	if ( id >= (int)records.size() ) {
+		records.resize(id + 1);
+		sentBytes.resize(id + 1, 0);
+		recvBytes.resize(id + 1, 0);
+		oversize.resize(id + 1, 0);
+	}
+}
+
+/**
+ * FUNCTION NAME: at
+ *
+ * DESCRIPTION: Record of node id for tick time, appended if missing
+ */
+NetStatRecord *NetStats::at(int id, int time) {
+	vector<NetStatRecord> &node = records[id];
+	if ( node.empty() || node.back().time != time ) {
+		NetStatRecord record;
+		record.time = time;
+		record.sent = 0;
+		record.recv = 0;
+		node.push_back(record);
+	}
+	return &node.back();
+}
+
+/**
+ * FUNCTION NAME: countSent
+ *
+ * DESCRIPTION: Count messages of bytes each sent by node id
+ */
+void NetStats::countSent(int id, int time, int bytes, int messages) {
+	at(id, time)->sent += messages;
+	sentBytes[id] += (long)bytes * messages;
+}
+
+/**
+ * FUNCTION NAME: countRecv
+ *
+ * DESCRIPTION: Count a message received by node id
+ */
+void NetStats::countRecv(int id, int time, int bytes) {
+	at(id, time)->recv++;
+	recvBytes[id] += bytes;
+}
+
+/**
+ * FUNCTION NAME: countOversize
+ *
+ * DESCRIPTION: Count messages of node id dropped for being too big to send
+ */
+void NetStats::countOversize(int id, int messages) {
+	oversize[id] += messages;
+}
+
+/**
+ * FUNCTION NAME: write
+ *
+ * DESCRIPTION: Write the msgcount.log report of the nodes ids starting at first for
+ * 				ticks before endtime
+ */
+void NetStats::write(FILE *file, int nodes, int endtime, int first) {
+	int i, j;
+	int sent_total, recv_total;
+	long sent_bytes_total = 0;
+	long oversize_total = 0;
+
+	for ( i = first; i < first + nodes; i++ ) {
+		fprintf(file, "node %3d ", i);
+		sent_total = 0;
+		recv_total = 0;
+
+		size_t next = 0;
+		for (j = 0; j < endtime; j++) {
+			int sent = 0, recv = 0;
+			if ( i < (int)records.size() && next < records[i].size() && records[i][next].time == j ) {
+				sent = records[i][next].sent;
+				recv = records[i][next].recv;
+				next++;
+			}
+
+			sent_total += sent;
+			recv_total += recv;
+			if (i != 67) {
+				fprintf(file, " (%4d, %4d)", sent, recv);
+				if (j % 10 == 9) {
+					fprintf(file, "\n         ");
+				}
+			}
+			else {
+				fprintf(file, "special %4d %4d %4d\n", j, sent, recv);
+			}
+		}
+		long sent_bytes = i < (int)sentBytes.size() ? sentBytes[i] : 0;
+		long recv_bytes = i < (int)recvBytes.size() ? recvBytes[i] : 0;
+		fprintf(file, "\n");
+		fprintf(file, "node %3d sent_total %6u  recv_total %6u\n", i, sent_total, recv_total);
+		fprintf(file, "node %3d sent_bytes %8ld  recv_bytes %8ld\n\n", i, sent_bytes, recv_bytes);
+		sent_bytes_total += sent_bytes;
+		oversize_total += i < (int)oversize.size() ? oversize[i] : 0;
+	}
+	fprintf(file, "total sent_bytes %10ld\n", sent_bytes_total);
+	fprintf(file, "total oversize_drops %6ld\n", oversize_total);
+}
@@ -0,0 +1,48 @@
+/**********************************
+ * FILE NAME: NetStats.h
+ *
+ * DESCRIPTION: Header file of the network message counters
+ **********************************/
+
+#ifndef _NETSTATS_H_
+#define _NETSTATS_H_
+
+#include "stdincludes.h"
+
+/**
+ * STRUCT NAME: NetStatRecord
+ *
+ * DESCRIPTION: Messages sent and received by a node during one tick
+ */
+typedef struct NetStatRecord {
+	int time;
+	int sent;
+	int recv;
+}NetStatRecord;
+
+/**
+ * CLASS NAME: NetStats
+ *
+ * DESCRIPTION: Per node message counters, sized at runtime. Only ticks in which a node
+ * 				sent or received something get a record, so idle nodes and idle ticks
+ * 				cost nothing.
+ */
+class NetStats {
+private:
+	// indexed by node id, records in increasing time order
+	vector< vector<NetStatRecord> > records;
+	vector<long> sentBytes;
+	vector<long> recvBytes;
+	// messages dropped for exceeding Params::MAX_MSG_SIZE
+	vector<long> oversize;
+	NetStatRecord *at(int id, int time);
+public:
+	NetStats(int nodes);
+	void addNode(int id);
+	void countSent(int id, int time, int bytes, int messages = 1);
+	void countRecv(int id, int time, int bytes);
+	void countOversize(int id, int messages = 1);
+	void write(FILE *file, int nodes, int endtime, int first = 1);
+};
+
+#endif /* _NETSTATS_H_ */
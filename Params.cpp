@@ -9,7 +9,10 @@
 /**
  * Constructor
  */
-Params::Params(): PORTNUM(8001) {}
+Params::Params(): PORTNUM(8001), DELTA_GOSSIP(0), NUM_THREADS(1), EVENT_DRIVEN(0),
+	ASYNC_LOG(1), LOG_FLUSH_BYTES(65536), LOG_FLUSH_MS(100), EVENT_LOG(0), SEED(0),
+	TRANSPORT(EMUL_TRANSPORT), FIRST_NODE_ID(1), SHM_NODES(0), TICK_MS(0),
+	DETECTOR(GOSSIP_DETECTOR), LIST_CODEC(FIXED_CODEC), VIEW(FULL_VIEW) {}
 
 /**
  * FUNCTION NAME: setparams
@@ -24,6 +27,12 @@ void Params::setparams(char *config_file) {
 	fscanf(fp,"\nDROP_MSG: %d", &DROP_MSG);
 	fscanf(fp,"\nMSG_DROP_PROB: %lf", &MSG_DROP_PROB);
 
+	// Optional "KEY: value" lines after the mandatory ones
+	char key[64], value[64];
+	while ( fscanf(fp, " %63[^:]: %63s", key, value) == 2 ) {
+		setparam(key, value);
+	}
+
 	//printf("Parameters of the test case: %d %d %d %lf\n", MAX_NNB, SINGLE_FAILURE, DROP_MSG, MSG_DROP_PROB);
 
 	EN_GPSZ = MAX_NNB;
@@ -39,6 +48,94 @@ void Params::setparams(char *config_file) {
 	return;
 }
 
+/**
+ * FUNCTION NAME: setparam
+ *
+ * DESCRIPTION: Set one of the optional parameters of the test case
+ */
+void Params::setparam(char *key, char *value) {
+	if ( 0 == strcmp(key, "DELTA_GOSSIP") ) {
+		DELTA_GOSSIP = atoi(value);
+	}
+	else if ( 0 == strcmp(key, "NUM_THREADS") ) {
+		NUM_THREADS = atoi(value);
+	}
+	else if ( 0 == strcmp(key, "EVENT_DRIVEN") ) {
+		EVENT_DRIVEN = atoi(value);
+	}
+	else if ( 0 == strcmp(key, "ASYNC_LOG") ) {
+		ASYNC_LOG = atoi(value);
+	}
+	else if ( 0 == strcmp(key, "LOG_FLUSH_BYTES") ) {
+		LOG_FLUSH_BYTES = atoi(value);
+	}
+	else if ( 0 == strcmp(key, "LOG_FLUSH_MS") ) {
+		LOG_FLUSH_MS = atoi(value);
+	}
+	else if ( 0 == strcmp(key, "EVENT_LOG") ) {
+		EVENT_LOG = atoi(value);
+	}
+	else if ( 0 == strcmp(key, "TRANSPORT") ) {
+		if ( 0 == strcmp(value, "udp") ) {
+			TRANSPORT = UDP_TRANSPORT;
+		}
+		else if ( 0 == strcmp(value, "shm") ) {
+			TRANSPORT = SHM_TRANSPORT;
+		}
+		else if ( 0 == strcmp(value, "emul") ) {
+			TRANSPORT = EMUL_TRANSPORT;
+		}
+		else {
+			printf("Unknown transport %s, using emul\n", value);
+		}
+	}
+	else if ( 0 == strcmp(key, "FIRST_NODE_ID") ) {
+		FIRST_NODE_ID = atoi(value);
+	}
+	else if ( 0 == strcmp(key, "SHM_NODES") ) {
+		SHM_NODES = atoi(value);
+	}
+	else if ( 0 == strcmp(key, "TICK_MS") ) {
+		TICK_MS = atoi(value);
+	}
+	else if ( 0 == strcmp(key, "DETECTOR") ) {
+		if ( 0 == strcmp(value, "swim") ) {
+			DETECTOR = SWIM_DETECTOR;
+		}
+		else if ( 0 == strcmp(value, "gossip") ) {
+			DETECTOR = GOSSIP_DETECTOR;
+		}
+		else {
+			printf("Unknown detector %s, using gossip\n", value);
+		}
+	}
+	else if ( 0 == strcmp(key, "LIST_CODEC") ) {
+		if ( 0 == strcmp(value, "varint") ) {
+			LIST_CODEC = VARINT_CODEC;
+		}
+		else if ( 0 == strcmp(value, "fixed") ) {
+			LIST_CODEC = FIXED_CODEC;
+		}
+		else {
+			printf("Unknown list codec %s, using fixed\n", value);
+		}
+	}
+	else if ( 0 == strcmp(key, "VIEW") ) {
+		if ( 0 == strcmp(value, "partial") ) {
+			VIEW = PARTIAL_VIEW;
+		}
+		else if ( 0 == strcmp(value, "full") ) {
+			VIEW = FULL_VIEW;
+		}
+		else {
+			printf("Unknown view %s, using full\n", value);
+		}
+	}
+	else {
+		printf("Ignoring unknown parameter %s\n", key);
+	}
+}
+
 /**
  * FUNCTION NAME: getcurrtime
  *
@@ -10,9 +10,16 @@
 #include "stdincludes.h"
 #include "Params.h"
 #include "Member.h"
+#include "Message.h"
 
 enum testTYPE { CREATE_TEST, READ_TEST, UPDATE_TEST, DELETE_TEST };
 
+enum detectorTYPE { GOSSIP_DETECTOR, SWIM_DETECTOR };
+
+enum transportTYPE { EMUL_TRANSPORT, UDP_TRANSPORT, SHM_TRANSPORT };
+
+enum viewTYPE { FULL_VIEW, PARTIAL_VIEW };
+
 /**
  * CLASS NAME: Params
  *
@@ -31,8 +38,24 @@ public:
 	int globaltime;
 	int allNodesJoined;
 	short PORTNUM;
+	int DELTA_GOSSIP;			// gossip only recently changed entries
+	int NUM_THREADS;			// threads of the simulation engine
+	int EVENT_DRIVEN;			// discrete-event instead of tick by tick simulation
+	int ASYNC_LOG;				// write dbg.log from a background thread
+	int LOG_FLUSH_BYTES;		// flush the logs after this many bytes
+	int LOG_FLUSH_MS;			// or once the oldest unflushed line is this old
+	int EVENT_LOG;				// record events in the binary events.bin
+	unsigned long SEED;			// seed of all random streams of the run
+	int TRANSPORT;				// network the nodes talk over
+	int FIRST_NODE_ID;			// id of the first node of this process
+	int SHM_NODES;				// nodes of all processes sharing the shm transport
+	int TICK_MS;				// real-time length of a tick, 0 to run flat out
+	int DETECTOR;				// failure detector run by the nodes
+	int LIST_CODEC;				// encoding of the membership lists sent
+	int VIEW;					// full membership list or HyParView partial view
 	Params();
 	void setparams(char *);
+	void setparam(char *key, char *value);
 	int getcurrtime();
 };
 
@@ -0,0 +1,185 @@
+/**********************************
+ * FILE NAME: PartialView.cpp
+ *
+ * DESCRIPTION: Definition of the partial membership view
+ **********************************/
+
+#include "PartialView.h"
+
+/**
+ * Constructor
+ */
+PartialView::PartialView(): self(0), activeMax(0), passiveMax(0) {}
+
+/**
+ * FUNCTION NAME: reset
+ *
+ * DESCRIPTION: Empty both views and set their owner and sizes
+ */
+void PartialView::reset(uint64_t self, int activeMax, int passiveMax) {
+	this->self = self;
+	this->activeMax = activeMax;
+	this->passiveMax = passiveMax;
+	active.clear();
+	heardAt.clear();
+	passive.clear();
+}
+
+/**
+ * FUNCTION NAME: indexOf
+ *
+ * DESCRIPTION: Position of key in keys, the views are small enough to scan
+ *
+ * RETURNS:
+ * index, -1 if absent
+ */
+int PartialView::indexOf(vector<uint64_t> &keys, uint64_t key) {
+	for ( size_t i = 0; i < keys.size(); i++ ) {
+		if ( keys[i] == key ) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+/**
+ * FUNCTION NAME: addActive
+ *
+ * DESCRIPTION: Move key into the active view, heard from at now. The caller makes
+ * 				room first.
+ */
+void PartialView::addActive(uint64_t key, int now) {
+	if ( key == self || isActive(key) || activeFull() ) {
+		return;
+	}
+	removePassive(key);
+	active.push_back(key);
+	heardAt.push_back(now);
+}
+
+/**
+ * FUNCTION NAME: removeActive
+ *
+ * DESCRIPTION: Take key out of the active view
+ *
+ * RETURNS:
+ * true if it was there
+ */
+bool PartialView::removeActive(uint64_t key) {
+	int i = indexOf(active, key);
+	if ( i < 0 ) {
+		return false;
+	}
+	active[i] = active.back();
+	active.pop_back();
+	heardAt[i] = heardAt.back();
+	heardAt.pop_back();
+	return true;
+}
+
+/**
+ * FUNCTION NAME: addPassive
+ *
+ * DESCRIPTION: Remember key in the passive view unless it is known already. A full
+ * 				view forgets a random peer to make room.
+ */
+void PartialView::addPassive(uint64_t key, Random *random) {
+	if ( key == self || passiveMax == 0 || isActive(key) || indexOf(passive, key) >= 0 ) {
+		return;
+	}
+	if ( passive.size() >= passiveMax ) {
+		passive[random->below(passive.size())] = key;
+		return;
+	}
+	passive.push_back(key);
+}
+
+/**
+ * FUNCTION NAME: removePassive
+ *
+ * DESCRIPTION: Take key out of the passive view
+ *
+ * RETURNS:
+ * true if it was there
+ */
+bool PartialView::removePassive(uint64_t key) {
+	int i = indexOf(passive, key);
+	if ( i < 0 ) {
+		return false;
+	}
+	passive[i] = passive.back();
+	passive.pop_back();
+	return true;
+}
+
+/**
+ * FUNCTION NAME: heard
+ *
+ * DESCRIPTION: Note that active peer key was heard from at now
+ */
+void PartialView::heard(uint64_t key, int now) {
+	int i = indexOf(active, key);
+	if ( i >= 0 ) {
+		heardAt[i] = now;
+	}
+}
+
+/**
+ * FUNCTION NAME: randomActive
+ *
+ * DESCRIPTION: Random active peer other than except
+ *
+ * RETURNS:
+ * its key, 0 if there is none
+ */
+uint64_t PartialView::randomActive(Random *random, uint64_t except) {
+	int skip = indexOf(active, except);
+	int n = active.size() - (skip >= 0 ? 1 : 0);
+	if ( n <= 0 ) {
+		return 0;
+	}
+	int i = random->below(n);
+	if ( skip >= 0 && i >= skip ) {
+		i++;
+	}
+	return active[i];
+}
+
+/**
+ * FUNCTION NAME: randomPassive
+ *
+ * DESCRIPTION: Random passive peer
+ *
+ * RETURNS:
+ * its key, 0 if there is none
+ */
+uint64_t PartialView::randomPassive(Random *random) {
+	if ( passive.empty() ) {
+		return 0;
+	}
+	return passive[random->below(passive.size())];
+}
+
+/**
+ * FUNCTION NAME: sample
+ *
+ * DESCRIPTION: Append to out up to n distinct random peers of the active or passive
+ * 				view, except except
+ */
+void PartialView::sample(bool fromActive, int n, uint64_t except, Random *random, vector<uint64_t> *out) {
+	vector<uint64_t> &keys = fromActive ? active : passive;
+	size_t first = out->size();
+	for ( size_t i = 0; i < keys.size(); i++ ) {
+		if ( keys[i] != except ) {
+			out->push_back(keys[i]);
+		}
+	}
+	int m = out->size() - first;
+	n = min(n, m);
+	// partial Fisher-Yates shuffle of the candidates appended
+	for ( int k = 0; k < n; k++ ) {
+		int j = k + random->below(m - k);
+		swap((*out)[first + k], (*out)[first + j]);
+	}
+	out->resize(first + n);
+}
@@ -0,0 +1,67 @@
+/**********************************
+ * FILE NAME: PartialView.h
+ *
+ * DESCRIPTION: Header file of the partial membership view
+ **********************************/
+
+#ifndef _PARTIALVIEW_H_
+#define _PARTIALVIEW_H_
+
+#include <stdint.h>
+#include "stdincludes.h"
+#include "Random.h"
+
+/**
+ * CLASS NAME: PartialView
+ *
+ * DESCRIPTION: The two views of a HyParView node, as packed addresses: a small active
+ * 				view of the peers it gossips with and watches, and a larger passive
+ * 				view of peers it knows of and may promote when an active one fails.
+ * 				Both are bounded, so the memory of a node does not depend on the
+ * 				group size. A peer is in at most one view and never the node itself.
+ */
+class PartialView {
+private:
+	uint64_t self;
+	size_t activeMax;
+	size_t passiveMax;
+	vector<uint64_t> active;
+	// tick each active peer was last heard from
+	vector<int> heardAt;
+	vector<uint64_t> passive;
+	static int indexOf(vector<uint64_t> &keys, uint64_t key);
+public:
+	PartialView();
+	void reset(uint64_t self, int activeMax, int passiveMax);
+	int activeSize() {
+		return active.size();
+	}
+	int passiveSize() {
+		return passive.size();
+	}
+	int getActiveMax() {
+		return activeMax;
+	}
+	bool activeFull() {
+		return active.size() >= activeMax;
+	}
+	uint64_t getActive(int i) {
+		return active[i];
+	}
+	int getHeardAt(int i) {
+		return heardAt[i];
+	}
+	bool isActive(uint64_t key) {
+		return indexOf(active, key) >= 0;
+	}
+	void addActive(uint64_t key, int now);
+	bool removeActive(uint64_t key);
+	void addPassive(uint64_t key, Random *random);
+	bool removePassive(uint64_t key);
+	void heard(uint64_t key, int now);
+	uint64_t randomActive(Random *random, uint64_t except);
+	uint64_t randomPassive(Random *random);
+	void sample(bool fromActive, int n, uint64_t except, Random *random, vector<uint64_t> *out);
+};
+
+#endif /* _PARTIALVIEW_H_ */
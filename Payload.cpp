@@ -0,0 +1,42 @@
+/**********************************
+ * FILE NAME: Payload.cpp
+ *
+ * DESCRIPTION: Definition of the reference counted message payload
+ **********************************/
+
+#include <new>
+#include "Payload.h"
+#include "MsgPool.h"
+
+/**
+ * FUNCTION NAME: create
+ *
+ * DESCRIPTION: Allocate an uninitialized payload of size bytes
+ */
+Payload *Payload::create(int size) {
+	void *mem = MsgPool::alloc(sizeof(Payload) + size);
+	return new (mem) Payload(size);
+}
+
+/**
+ * FUNCTION NAME: create
+ *
+ * DESCRIPTION: Allocate a payload holding a copy of data
+ */
+Payload *Payload::create(const char *data, int size) {
+	Payload *payload = create(size);
+	memcpy(payload->getData(), data, size);
+	return payload;
+}
+
+/**
+ * FUNCTION NAME: release
+ *
+ * DESCRIPTION: Drop one reference, freeing the payload with the last one
+ */
+void Payload::release() {
+	if ( refs.fetch_sub(1, memory_order_acq_rel) == 1 ) {
+		this->~Payload();
+		MsgPool::release(this);
+	}
+}
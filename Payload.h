@@ -0,0 +1,44 @@
+/**********************************
+ * FILE NAME: Payload.h
+ *
+ * DESCRIPTION: Header file of the reference counted message payload
+ **********************************/
+
+#ifndef _PAYLOAD_H_
+#define _PAYLOAD_H_
+
+#include <atomic>
+#include "stdincludes.h"
+
+/**
+ * CLASS NAME: Payload
+ *
+ * DESCRIPTION: Immutable message body shared by every message that carries it.
+ * 				The bytes live right after the object in the same pooled block.
+ * 				create() returns it with one reference owned by the caller.
+ */
+class Payload {
+private:
+	atomic<int> refs;
+	int size;
+	Payload(int size): refs(1), size(size) {}
+	~Payload() {}
+public:
+	static Payload *create(int size);
+	static Payload *create(const char *data, int size);
+	static Payload *fromData(char *data) {
+		return (Payload *)data - 1;
+	}
+	char *getData() {
+		return (char *)(this + 1);
+	}
+	int getSize() {
+		return size;
+	}
+	void retain(int count = 1) {
+		refs.fetch_add(count, memory_order_relaxed);
+	}
+	void release();
+};
+
+#endif /* _PAYLOAD_H_ */
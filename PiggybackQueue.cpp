@@ -0,0 +1,94 @@
+/**********************************
+ * FILE NAME: PiggybackQueue.cpp
+ *
+ * DESCRIPTION: Definition of the dissemination queue
+ **********************************/
+
+#include "PiggybackQueue.h"
+
+/**
+ * Constructor
+ */
+PiggybackQueue::PiggybackQueue(size_t capacity): capacity(capacity) {}
+
+/**
+ * FUNCTION NAME: push
+ *
+ * DESCRIPTION: Queue an update about member key, replacing any older one about it.
+ * 				It goes first, not sent yet.
+ */
+void PiggybackQueue::push(uint64_t key, const SwimUpdate &update) {
+	for ( size_t i = 0; i < rumors.size(); i++ ) {
+		if ( rumors[i].key == key ) {
+			rumors.erase(rumors.begin() + i);
+			break;
+		}
+	}
+	Rumor r;
+	r.key = key;
+	r.update = update;
+	r.sent = 0;
+	rumors.insert(rumors.begin(), r);
+	if ( rumors.size() > capacity ) {
+		rumors.pop_back();
+	}
+}
+
+/**
+ * FUNCTION NAME: fill
+ *
+ * DESCRIPTION: Add to enc as many updates as fit in budget bytes: first any update
+ * 				about the receiver toKey, then the least sent ones. Updates sent limit
+ * 				times are retired.
+ *
+ * RETURNS:
+ * number of updates added
+ */
+int PiggybackQueue::fill(SwimEncoder *enc, int budget, uint64_t toKey, int limit) {
+	int n = min((int)rumors.size(), max(budget, 0) / (int)sizeof(SwimUpdate));
+	if ( n == 0 ) {
+		return 0;
+	}
+
+	int to = -1;
+	for ( size_t i = 0; i < rumors.size(); i++ ) {
+		if ( rumors[i].key == toKey ) {
+			to = i;
+			break;
+		}
+	}
+	// the receiver's update is outside the prefix: it takes the last place
+	Rumor toRumor;
+	int prefix = n;
+	if ( to >= n ) {
+		prefix = n - 1;
+		toRumor = rumors[to];
+		rumors.erase(rumors.begin() + to);
+		enc->add(toRumor.update);
+		toRumor.sent++;
+	}
+	for ( int i = 0; i < prefix; i++ ) {
+		enc->add(rumors[i].update);
+		rumors[i].sent++;
+	}
+
+	// the prefix and the rest are each still ordered
+	inplace_merge(rumors.begin(), rumors.begin() + prefix, rumors.end(), fewerSent);
+	if ( to >= n ) {
+		rumors.insert(upper_bound(rumors.begin(), rumors.end(), toRumor, fewerSent), toRumor);
+	}
+	// the limit follows the cluster size and may have shrunk below older counts
+	while ( !rumors.empty() && rumors.back().sent >= limit ) {
+		rumors.pop_back();
+	}
+	return n;
+}
+
+/**
+ * FUNCTION NAME: clear
+ *
+ * DESCRIPTION: Drop every update
+ */
+void PiggybackQueue::clear() {
+	rumors.clear();
+}
@@ -0,0 +1,51 @@
+/**********************************
+ * FILE NAME: PiggybackQueue.h
+ *
+ * DESCRIPTION: Header file of the dissemination queue
+ **********************************/
+
+#ifndef _PIGGYBACKQUEUE_H_
+#define _PIGGYBACKQUEUE_H_
+
+#include <stdint.h>
+#include "stdincludes.h"
+#include "Message.h"
+
+/**
+ * STRUCT NAME: Rumor
+ *
+ * DESCRIPTION: Membership update being disseminated, and how often it has been sent
+ */
+typedef struct Rumor {
+	uint64_t key;
+	SwimUpdate update;
+	int sent;
+}Rumor;
+
+/**
+ * CLASS NAME: PiggybackQueue
+ *
+ * DESCRIPTION: Membership updates waiting to ride on outgoing messages. The queue is
+ * 				kept ordered by times sent, the freshest updates first, so filling a
+ * 				message takes a prefix. An update is retired once sent as often as the
+ * 				caller's limit, and when the queue is full a new update pushes out
+ * 				the most sent one.
+ */
+class PiggybackQueue {
+private:
+	vector<Rumor> rumors;
+	size_t capacity;
+	static bool fewerSent(const Rumor &a, const Rumor &b) {
+		return a.sent < b.sent;
+	}
+public:
+	PiggybackQueue(size_t capacity);
+	int size() {
+		return rumors.size();
+	}
+	void push(uint64_t key, const SwimUpdate &update);
+	int fill(SwimEncoder *enc, int budget, uint64_t toKey, int limit);
+	void clear();
+};
+
+#endif /* _PIGGYBACKQUEUE_H_ */
@@ -0,0 +1,56 @@
+/**********************************
+ * FILE NAME: Random.h
+ *
+ * DESCRIPTION: Header file of the seeded random streams
+ **********************************/
+
+#ifndef _RANDOM_H_
+#define _RANDOM_H_
+
+#include <stdint.h>
+#include "stdincludes.h"
+
+/*
+ * Macros
+ */
+// Streams that do not belong to a node; nodes use their id
+#define STREAM_NETWORK 0xFFFFFFFF00000001ULL
+#define STREAM_APPLICATION 0xFFFFFFFF00000002ULL
+#define GOLDEN_GAMMA 0x9E3779B97F4A7C15ULL
+
+/**
+ * CLASS NAME: Random
+ *
+ * DESCRIPTION: SplitMix64 generator. Each stream starts from a state derived from
+ * 				the run seed and the stream number, so streams are independent of each
+ * 				other and of the order in which they are used.
+ */
+class Random {
+private:
+	uint64_t state;
+	static uint64_t mix(uint64_t z) {
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+		return z ^ (z >> 31);
+	}
+public:
+	Random(): state(0) {}
+	Random(uint64_t seed, uint64_t stream) {
+		setSeed(seed, stream);
+	}
+	void setSeed(uint64_t seed, uint64_t stream) {
+		state = mix(seed ^ mix(stream * GOLDEN_GAMMA));
+	}
+	uint64_t next() {
+		state += GOLDEN_GAMMA;
+		return mix(state);
+	}
+	/**
+	 * Uniform integer in [0, n)
+	 */
+	uint32_t below(uint32_t n) {
+		return (uint32_t)(((next() >> 32) * n) >> 32);
+	}
+};
+
+#endif /* _RANDOM_H_ */
@@ -0,0 +1,347 @@
+/**********************************
+ * FILE NAME: ShmNet.cpp
+ *
+ * DESCRIPTION: Definition of the shared-memory transport
+ **********************************/
+
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/stat.h>
+#include <climits>
+#include "ShmNet.h"
+
+/**
+ * Constructor. The process hosting node 1 creates and initializes the region,
+ * the others wait until it is ready.
+ */
+ShmNet::ShmNet(Params *p): stats(p->EN_GPSZ) {
+	par = p;
+	log = NULL;
+	nextid = par->FIRST_NODE_ID;
+	answered = 0;
+	random.setSeed(par->SEED, STREAM_NETWORK);
+	creator = (par->FIRST_NODE_ID == 1);
+
+	int nodes = par->SHM_NODES > 0 ? par->SHM_NODES : par->FIRST_NODE_ID - 1 + par->EN_GPSZ;
+	length = sizeof(ShmHeader) + nodes * sizeof(ShmRing);
+
+	int fd;
+	if ( creator ) {
+		shm_unlink(SHM_NAME);
+		fd = shm_open(SHM_NAME, O_RDWR | O_CREAT | O_EXCL, 0600);
+		if ( fd < 0 || ftruncate(fd, length) != 0 ) {
+			perror(SHM_NAME);
+			exit(1);
+		}
+	}
+	else {
+		int waited = 0;
+		while ( (fd = shm_open(SHM_NAME, O_RDWR, 0600)) < 0 && waited < SHM_OPEN_TIMEOUT_MS ) {
+			usleep(10000);
+			waited += 10;
+		}
+		struct stat st;
+		if ( fd < 0 || fstat(fd, &st) != 0 ) {
+			perror(SHM_NAME);
+			exit(1);
+		}
+		// the creator may not have sized it yet
+		while ( st.st_size == 0 && waited < SHM_OPEN_TIMEOUT_MS ) {
+			usleep(10000);
+			waited += 10;
+			fstat(fd, &st);
+		}
+		length = st.st_size;
+	}
+
+	header = (ShmHeader *)mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if ( header == MAP_FAILED ) {
+		perror("mmap");
+		exit(1);
+	}
+
+	if ( creator ) {
+		// ftruncate zero-filled the region, only the sequence numbers need setting
+		for ( int id = 1; id <= nodes; id++ ) {
+			ShmRing *r = ring(id);
+			for ( uint64_t i = 0; i < SHM_SLOTS; i++ ) {
+				r->slots[i].seq.store(i, memory_order_relaxed);
+			}
+			r->bellOwner.store(id, memory_order_relaxed);
+		}
+		strcpy(header->magic, SHM_MAGIC);
+		header->nodes = nodes;
+		header->ready.store(1, memory_order_release);
+	}
+	else {
+		int waited = 0;
+		while ( header->ready.load(memory_order_acquire) == 0 && waited < SHM_OPEN_TIMEOUT_MS ) {
+			usleep(10000);
+			waited += 10;
+		}
+		if ( header->ready.load(memory_order_acquire) == 0 || 0 != strcmp(header->magic, SHM_MAGIC) ) {
+			fprintf(stderr, "%s: not ready\n", SHM_NAME);
+			exit(1);
+		}
+	}
+}
+
+/**
+ * Destructor
+ */
+ShmNet::~ShmNet() {
+	munmap(header, length);
+}
+
+/**
+ * FUNCTION NAME: ENinit
+ *
+ * DESCRIPTION: Give the node the next id and make this process its bell owner
+ */
+void *ShmNet::ENinit(Address *myaddr, short port) {
+	int id = nextid++;
+	*(int *)(myaddr->addr) = id;
+	*(short *)(&myaddr->addr[4]) = 0;
+
+	if ( id > header->nodes ) {
+		fprintf(stderr, "Node %d does not fit in %s, raise SHM_NODES\n", id, SHM_NAME);
+		exit(1);
+	}
+	ring(id)->bellOwner.store(hosted.empty() ? id : hosted[0]);
+	hosted.push_back(id);
+	stats.addNode(id);
+	return myaddr;
+}
+
+/**
+ * FUNCTION NAME: wake
+ *
+ * DESCRIPTION: Tell the process owning bell that a message arrived
+ */
+void ShmNet::wake(ShmRing *owner) {
+	owner->bell.fetch_add(1);
+	if ( owner->sleeping.load() ) {
+		syscall(SYS_futex, (uint32_t *)&owner->bell, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+	}
+}
+
+/**
+ * FUNCTION NAME: push
+ *
+ * DESCRIPTION: Copy the payload sent by from into the mailbox r
+ *
+ * RETURNS:
+ * false if the mailbox is full
+ */
+bool ShmNet::push(ShmRing *r, Address *from, Payload *payload) {
+	ShmSlot *slot;
+	uint64_t pos = r->head.load(memory_order_relaxed);
+	while ( true ) {
+		slot = &r->slots[pos & (SHM_SLOTS - 1)];
+		uint64_t seq = slot->seq.load(memory_order_acquire);
+		if ( seq == pos ) {
+			if ( r->head.compare_exchange_weak(pos, pos + 1, memory_order_relaxed) ) {
+				break;
+			}
+		}
+		else if ( seq < pos ) {
+			// mailbox full: the message is lost, as in a full socket buffer
+			return false;
+		}
+		else {
+			pos = r->head.load(memory_order_relaxed);
+		}
+	}
+	slot->size = payload->getSize();
+	memcpy(slot->from, from->addr, sizeof(slot->from));
+	memcpy(slot->data, payload->getData(), payload->getSize());
+	slot->seq.store(pos + 1, memory_order_release);
+	return true;
+}
+
+/**
+ * FUNCTION NAME: ENsend
+ *
+ * DESCRIPTION: Copy the payload into the mailbox of its destination
+ *
+ * RETURNS:
+ * size, 0 if dropped
+ */
+int ShmNet::ENsend(Address *myaddr, Address *toaddr, Payload *payload) {
+	int src = *(int *)(myaddr->addr);
+	int dst = *(int *)(toaddr->addr);
+	int size = payload->getSize();
+	int sendmsg = random.below(100);
+
+	if ( !Transport::fits(size, par->MAX_MSG_SIZE) || size > SHM_SLOT_SIZE ) {
+		stats.countOversize(src);
+		return 0;
+	}
+	if ( dst < 1 || dst > header->nodes || (par->dropmsg && sendmsg < (int) (par->MSG_DROP_PROB * 100)) ) {
+		return 0;
+	}
+
+	ShmRing *r = ring(dst);
+	if ( !push(r, myaddr, payload) ) {
+		return 0;
+	}
+	atomic_thread_fence(memory_order_seq_cst);
+	wake(ring(r->bellOwner.load(memory_order_relaxed)));
+
+	stats.countSent(src, par->getcurrtime(), size);
+	if ( log != NULL ) {
+		log->logEvent(EV_SEND, myaddr, toaddr, size);
+	}
+	return size;
+}
+
+/**
+ * FUNCTION NAME: ENsendMulti
+ *
+ * DESCRIPTION: Copy the payload into the mailbox of each of the count addresses in
+ * 				toaddrs. Drops are decided in one pass, and each process with a
+ * 				destination is woken once, after all the copies.
+ *
+ * RETURNS:
+ * number of messages not dropped
+ */
+int ShmNet::ENsendMulti(Address *myaddr, Address *toaddrs, int count, Payload *payload) {
+	int src = *(int *)(myaddr->addr);
+	int size = payload->getSize();
+	bool fits = Transport::fits(size, par->MAX_MSG_SIZE) && size <= SHM_SLOT_SIZE;
+	int sent = 0;
+
+	if ( !fits ) {
+		stats.countOversize(src, count);
+	}
+	owners.clear();
+	for ( int i = 0; i < count; i++ ) {
+		int sendmsg = random.below(100);
+		int dst = *(int *)(toaddrs[i].addr);
+		if ( dst < 1 || dst > header->nodes || !fits || (par->dropmsg && sendmsg < (int) (par->MSG_DROP_PROB * 100)) ) {
+			continue;
+		}
+
+		ShmRing *r = ring(dst);
+		if ( !push(r, myaddr, payload) ) {
+			continue;
+		}
+		int owner = r->bellOwner.load(memory_order_relaxed);
+		if ( find(owners.begin(), owners.end(), owner) == owners.end() ) {
+			owners.push_back(owner);
+		}
+		if ( log != NULL ) {
+			log->logEvent(EV_SEND, myaddr, &toaddrs[i], size);
+		}
+		sent++;
+	}
+
+	if ( sent > 0 ) {
+		atomic_thread_fence(memory_order_seq_cst);
+		for ( size_t i = 0; i < owners.size(); i++ ) {
+			wake(ring(owners[i]));
+		}
+		stats.countSent(src, par->getcurrtime(), size, sent);
+	}
+	return sent;
+}
+
+/**
+ * FUNCTION NAME: ENrecv
+ *
+ * DESCRIPTION: Hand every message waiting for myaddr to enq. As with EmulNet, the
+ * 				receiver releases each buffer with Payload::fromData(buffer)->release().
+ *
+ * RETURN:
+ * 0
+ */
+int ShmNet::ENrecv(Address *myaddr, int (* enq)(void *, char *, int), struct timeval *t, int times, void *queue) {
+	int id = *(int *)(myaddr->addr);
+	if ( id < 1 || id > header->nodes ) {
+		return 0;
+	}
+
+	ShmRing *r = ring(id);
+	while ( true ) {
+		ShmSlot *slot = &r->slots[r->tail & (SHM_SLOTS - 1)];
+		if ( slot->seq.load(memory_order_acquire) != r->tail + 1 ) {
+			break;
+		}
+		int size = slot->size;
+		Address from;
+		memcpy(from.addr, slot->from, sizeof(from.addr));
+		Payload *payload = Payload::create(slot->data, size);
+		slot->seq.store(r->tail + SHM_SLOTS, memory_order_release);
+		r->tail++;
+
+		(*enq)(queue, payload->getData(), size);
+		stats.countRecv(id, par->getcurrtime(), size);
+		if ( log != NULL ) {
+			log->logEvent(EV_RECV, myaddr, &from, size);
+		}
+	}
+	return 0;
+}
+
+/**
+ * FUNCTION NAME: ENwait
+ *
+ * DESCRIPTION: Sleep until a message arrives for a node of this process, at most ms.
+ * 				Messages already waiting when the bell was last answered do not count,
+ * 				so a node that is not receiving cannot keep the process awake.
+ *
+ * RETURNS:
+ * true if the bell rang
+ */
+bool ShmNet::ENwait(int ms) {
+	if ( hosted.empty() ) {
+		return Transport::ENwait(ms);
+	}
+
+	ShmRing *owner = ring(hosted[0]);
+	if ( owner->bell.load() == answered ) {
+		owner->sleeping.fetch_add(1);
+		atomic_thread_fence(memory_order_seq_cst);
+		struct timespec timeout;
+		timeout.tv_sec = ms / 1000;
+		timeout.tv_nsec = (ms % 1000) * 1000000L;
+		// returns at once if a sender rang the bell since it was answered
+		syscall(SYS_futex, (uint32_t *)&owner->bell, FUTEX_WAIT, answered, &timeout, NULL, 0);
+		owner->sleeping.fetch_sub(1);
+	}
+
+	uint32_t bell = owner->bell.load();
+	if ( bell == answered ) {
+		return false;
+	}
+	answered = bell;
+	return true;
+}
+
+/**
+ * FUNCTION NAME: ENsetLog
+ *
+ * DESCRIPTION: Record sends and receives in the event log of log
+ */
+void ShmNet::ENsetLog(Log *log) {
+	this->log = log;
+}
+
+/**
+ * FUNCTION NAME: ENcleanup
+ *
+ * DESCRIPTION: Write msgcount.log and remove the region's name. Processes still
+ * 				attached keep their mapping. Called exactly once at the end of the program.
+ */
+int ShmNet::ENcleanup() {
+	if ( creator ) {
+		shm_unlink(SHM_NAME);
+	}
+
+	FILE* file = fopen("msgcount.log", "w+");
+	stats.write(file, par->EN_GPSZ, par->getcurrtime(), par->FIRST_NODE_ID);
+	fclose(file);
+	return 0;
+}
@@ -0,0 +1,120 @@
+/**********************************
+ * FILE NAME: ShmNet.h
+ *
+ * DESCRIPTION: Header file of the shared-memory transport
+ **********************************/
+
+#ifndef _SHMNET_H_
+#define _SHMNET_H_
+
+#include <atomic>
+#include <stdint.h>
+#include "stdincludes.h"
+#include "Params.h"
+#include "Member.h"
+#include "Payload.h"
+#include "NetStats.h"
+#include "Random.h"
+#include "Log.h"
+#include "Transport.h"
+
+/*
+ * Macros
+ */
+#define SHM_NAME "/mp1net"
+#define SHM_MAGIC "MP1SHM2"
+// Messages a node can have waiting, a power of two
+#define SHM_SLOTS 64
+// Largest message, enough for Params::MAX_MSG_SIZE
+#define SHM_SLOT_SIZE 4096
+// How long a process waits for the one creating the region
+#define SHM_OPEN_TIMEOUT_MS 10000
+
+/**
+ * STRUCT NAME: ShmSlot
+ *
+ * DESCRIPTION: One message. seq tells producers and the consumer whose turn it is.
+ */
+typedef struct ShmSlot {
+	atomic<uint64_t> seq;
+	int32_t size;
+	// sender address
+	char from[6];
+	char data[SHM_SLOT_SIZE];
+}ShmSlot;
+
+/**
+ * STRUCT NAME: ShmRing
+ *
+ * DESCRIPTION: Mailbox of one node: bounded ring with any number of producers, in any
+ * 				process, and one consumer. bell is the futex word of the hosting
+ * 				process, only used in the ring of its first node (bellOwner).
+ */
+typedef struct ShmRing {
+	atomic<uint64_t> head;
+	char pad1[56];
+	// only touched by the consumer
+	uint64_t tail;
+	atomic<uint32_t> bell;
+	atomic<int32_t> sleeping;
+	atomic<int32_t> bellOwner;
+	char pad2[44];
+	ShmSlot slots[SHM_SLOTS];
+}ShmRing;
+
+/**
+ * STRUCT NAME: ShmHeader
+ *
+ * DESCRIPTION: Start of the region, followed by one ring per node id from 1 to nodes
+ */
+typedef struct ShmHeader {
+	char magic[8];
+	int32_t nodes;
+	atomic<int32_t> ready;
+	char pad[48];
+}ShmHeader;
+
+/**
+ * CLASS NAME: ShmNet
+ *
+ * DESCRIPTION: Transport through a shared memory region, so that nodes in separate
+ * 				processes on one host talk without system calls. The process hosting
+ * 				node 1 creates the region; the others attach to it. A process that
+ * 				has nothing to do sleeps on a futex until a message arrives for one
+ * 				of its nodes. Message drops are emulated as in EmulNet.
+ */
+class ShmNet: public Transport {
+private:
+	Params *par;
+	NetStats stats;
+	Random random;
+	Log *log;
+	bool creator;
+	size_t length;
+	ShmHeader *header;
+	int nextid;
+	// ids of the nodes hosted by this process
+	vector<int> hosted;
+	// bell count when ENwait last returned
+	uint32_t answered;
+	ShmRing *ring(int id) {
+		return (ShmRing *)(header + 1) + (id - 1);
+	}
+	// bell owners to wake at the end of an ENsendMulti
+	vector<int> owners;
+	bool push(ShmRing *r, Address *from, Payload *payload);
+	void wake(ShmRing *owner);
+public:
+	ShmNet(Params *p);
+	virtual ~ShmNet();
+	void *ENinit(Address *myaddr, short port);
+	using Transport::ENsend;
+	int ENsend(Address *myaddr, Address *toaddr, Payload *payload);
+	int ENsendMulti(Address *myaddr, Address *toaddrs, int count, Payload *payload);
+	int ENrecv(Address *myaddr, int (* enq)(void *, char *, int), struct timeval *t, int times, void *queue);
+	bool ENwait(int ms);
+	void ENsetLog(Log *log);
+	int ENcleanup();
+};
+
+#endif /* _SHMNET_H_ */
@@ -0,0 +1,60 @@
+/**********************************
+ * FILE NAME: TimerWheel.cpp
+ *
+ * DESCRIPTION: Definition of the hashed timing wheel
+ **********************************/
+
+#include "TimerWheel.h"
+
+/**
+ * Constructor
+ *
+ * span is the largest distance between now and a deadline the wheel should hold
+ * without wrapping. Ticks up to start are considered already expired.
+ */
+TimerWheel::TimerWheel(int span, int start): current(start) {
+	int size = 1;
+	while ( size <= span ) {
+		size <<= 1;
+	}
+	slots.resize(size);
+	mask = size - 1;
+}
+
+/**
+ * FUNCTION NAME: schedule
+ *
+ * DESCRIPTION: Make key due at tick deadline
+ */
+void TimerWheel::schedule(int64_t key, int deadline) {
+	if ( deadline <= current ) {
+		deadline = current + 1;
+	}
+	TimerItem item;
+	item.key = key;
+	item.deadline = deadline;
+	slots[deadline & mask].push_back(item);
+}
+
+/**
+ * FUNCTION NAME: advance
+ *
+ * DESCRIPTION: Expire every tick up to now, appending the due items to due in deadline order
+ */
+void TimerWheel::advance(int now, vector<TimerItem> *due) {
+	while ( current < now ) {
+		current++;
+		vector<TimerItem> &slot = slots[current & mask];
+		size_t kept = 0;
+		for ( size_t i = 0; i < slot.size(); i++ ) {
+			if ( slot[i].deadline <= current ) {
+				due->push_back(slot[i]);
+			}
+			else {
+				// deadline more than one revolution away
+				slot[kept++] = slot[i];
+			}
+		}
+		slot.resize(kept);
+	}
+}
@@ -0,0 +1,46 @@
+/**********************************
+ * FILE NAME: TimerWheel.h
+ *
+ * DESCRIPTION: Header file of the hashed timing wheel
+ **********************************/
+
+#ifndef _TIMERWHEEL_H_
+#define _TIMERWHEEL_H_
+
+#include <stdint.h>
+#include "stdincludes.h"
+
+/**
+ * STRUCT NAME: TimerItem
+ *
+ * DESCRIPTION: A key that becomes due at tick deadline
+ */
+typedef struct TimerItem {
+	int64_t key;
+	int deadline;
+}TimerItem;
+
+/**
+ * CLASS NAME: TimerWheel
+ *
+ * DESCRIPTION: Hashed timing wheel keyed by tick. Items land in slot deadline % size,
+ * 				so advancing one tick only touches the items hashed to that tick.
+ * 				Items are never cancelled: the owner keeps one pending item per key,
+ * 				re-arms it when it fires early and ignores the ones its state outdated.
+ */
+class TimerWheel {
+private:
+	vector< vector<TimerItem> > slots;
+	int mask;
+	// last tick that has been expired
+	int current;
+public:
+	TimerWheel(int span, int start);
+	void schedule(int64_t key, int deadline);
+	void advance(int now, vector<TimerItem> *due);
+	int getCurrent() {
+		return current;
+	}
+};
+
+#endif /* _TIMERWHEEL_H_ */
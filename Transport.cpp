@@ -0,0 +1,68 @@
+/**********************************
+ * FILE NAME: Transport.cpp
+ *
+ * DESCRIPTION: Definition of the sends shared by all transports
+ **********************************/
+
+#include "Transport.h"
+#include "EmulNet.h"
+
+/**
+ * FUNCTION NAME: ENsend
+ *
+ * DESCRIPTION: Copy data into a payload and send it
+ *
+ * RETURNS:
+ * size
+ */
+int Transport::ENsend(Address *myaddr, Address *toaddr, char *data, int size) {
+	Payload *payload = Payload::create(data, size);
+	int ret = this->ENsend(myaddr, toaddr, payload);
+	payload->release();
+	return ret;
+}
+
+/**
+ * FUNCTION NAME: ENsend
+ *
+ * DESCRIPTION: Copy data into a payload and send it
+ *
+ * RETURNS:
+ * size
+ */
+int Transport::ENsend(Address *myaddr, Address *toaddr, string data) {
+	return this->ENsend(myaddr, toaddr, (char *)data.data(), (data.length() * sizeof(char)));
+}
+
+/**
+ * FUNCTION NAME: fits
+ *
+ * DESCRIPTION: EmulNet counts its en_msg header against Params::MAX_MSG_SIZE. The
+ * 				other transports apply the same limit, so that each of them drops the
+ * 				same messages as too large.
+ *
+ * RETURNS:
+ * true if a message of size bytes may be sent
+ */
+bool Transport::fits(int size, int maxMsgSize) {
+	return size + (int)sizeof(en_msg) < maxMsgSize;
+}
+
+/**
+ * FUNCTION NAME: ENsendMulti
+ *
+ * DESCRIPTION: Send payload to each of the count addresses in toaddrs. Transports that
+ * 				can do better than one ENsend per destination override it.
+ *
+ * RETURNS:
+ * number of messages not dropped
+ */
+int Transport::ENsendMulti(Address *myaddr, Address *toaddrs, int count, Payload *payload) {
+	int sent = 0;
+	for ( int i = 0; i < count; i++ ) {
+		if ( this->ENsend(myaddr, &toaddrs[i], payload) > 0 ) {
+			sent++;
+		}
+	}
+	return sent;
+}
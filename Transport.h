@@ -0,0 +1,46 @@
+/**********************************
+ * FILE NAME: Transport.h
+ *
+ * DESCRIPTION: Header file of the interface between nodes and the network
+ **********************************/
+
+#ifndef _TRANSPORT_H_
+#define _TRANSPORT_H_
+
+#include "stdincludes.h"
+#include "Member.h"
+#include "Payload.h"
+
+// Bytes of Params::MAX_MSG_SIZE a transport may need for its own header
+#define TRANSPORT_HEADROOM 64
+
+/**
+ * CLASS NAME: Transport
+ *
+ * DESCRIPTION: What MP1Node needs from a network. EmulNet implements it in memory,
+ * 				UdpNet over loopback sockets, ShmNet over shared memory between
+ * 				processes.
+ */
+class Transport {
+public:
+	virtual ~Transport() {}
+	virtual void *ENinit(Address *myaddr, short port) = 0;
+	virtual int ENsend(Address *myaddr, Address *toaddr, Payload *payload) = 0;
+	int ENsend(Address *myaddr, Address *toaddr, char *data, int size);
+	int ENsend(Address *myaddr, Address *toaddr, string data);
+	// Send one payload to count destinations, returns the messages not dropped
+	virtual int ENsendMulti(Address *myaddr, Address *toaddrs, int count, Payload *payload);
+	virtual int ENrecv(Address *myaddr, int (* enq)(void *, char *, int), struct timeval *t, int times, void *queue) = 0;
+	// Push out messages a transport batches, called at the end of every tick
+	virtual void ENflush() {}
+	// Sleep until a message may be waiting, at most ms; true if one surely is
+	virtual bool ENwait(int ms) {
+		usleep(ms * 1000);
+		return false;
+	}
+	virtual int ENcleanup() = 0;
+	// Whether a message of size bytes is within maxMsgSize, the same for all transports
+	static bool fits(int size, int maxMsgSize);
+};
+
+#endif /* _TRANSPORT_H_ */
@@ -0,0 +1,341 @@
+/**********************************
+ * FILE NAME: UdpNet.cpp
+ *
+ * DESCRIPTION: Definition of the UDP transport
+ **********************************/
+
+#include <arpa/inet.h>
+#include "UdpNet.h"
+
+/**
+ * Constructor
+ */
+UdpNet::UdpNet(Params *p): stats(p->EN_GPSZ) {
+	par = p;
+	log = NULL;
+	nextid = par->FIRST_NODE_ID;
+	polledAt = -1;
+	random.setSeed(par->SEED, STREAM_NETWORK);
+
+	epfd = epoll_create1(0);
+	if ( epfd < 0 ) {
+		perror("epoll_create1");
+		exit(1);
+	}
+
+	buffers.resize(UDP_BATCH * UDP_BUFFER);
+	msgs.resize(UDP_BATCH);
+	iovs.resize(UDP_BATCH);
+	names.resize(UDP_BATCH);
+}
+
+/**
+ * Destructor
+ */
+UdpNet::~UdpNet() {
+	for ( size_t i = 0; i < sockets.size(); i++ ) {
+		if ( sockets[i] >= 0 ) {
+			close(sockets[i]);
+		}
+	}
+	close(epfd);
+}
+
+/**
+ * FUNCTION NAME: addressOf
+ *
+ * DESCRIPTION: Loopback socket address of node id
+ */
+struct sockaddr_in UdpNet::addressOf(int id) {
+	struct sockaddr_in sa;
+	memset(&sa, 0, sizeof(sa));
+	sa.sin_family = AF_INET;
+	sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	sa.sin_port = htons(par->PORTNUM + id);
+	return sa;
+}
+
+/**
+ * FUNCTION NAME: ENinit
+ *
+ * DESCRIPTION: Give the node the next id and bind its socket
+ */
+void *UdpNet::ENinit(Address *myaddr, short port) {
+	int id = nextid++;
+	*(int *)(myaddr->addr) = id;
+	*(short *)(&myaddr->addr[4]) = 0;
+
+	int fd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, 0);
+	if ( fd < 0 ) {
+		perror("socket");
+		exit(1);
+	}
+	int rcvbuf = UDP_RCVBUF;
+	setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+	struct sockaddr_in sa = addressOf(id);
+	if ( bind(fd, (struct sockaddr *)&sa, sizeof(sa)) != 0 ) {
+		fprintf(stderr, "Cannot bind node %d to port %d: %s\n", id, par->PORTNUM + id, strerror(errno));
+		exit(1);
+	}
+
+	struct epoll_event ev;
+	ev.events = EPOLLIN;
+	ev.data.u32 = id;
+	epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev);
+
+	if ( id >= (int)sockets.size() ) {
+		sockets.resize(id + 1, -1);
+		readable.resize(id + 1, 0);
+		outgoing.resize(id + 1);
+	}
+	sockets[id] = fd;
+	events.resize(events.size() + 1);
+	stats.addNode(id);
+	return myaddr;
+}
+
+/**
+ * FUNCTION NAME: ENsend
+ *
+ * DESCRIPTION: Queue the payload for the sender's next sendmmsg. The message takes its
+ * 				own reference to the payload.
+ *
+ * RETURNS:
+ * size, 0 if dropped
+ */
+int UdpNet::ENsend(Address *myaddr, Address *toaddr, Payload *payload) {
+	int src = *(int *)(myaddr->addr);
+	int dst = *(int *)(toaddr->addr);
+	int size = payload->getSize();
+	int sendmsg = random.below(100);
+
+	if ( src < 0 || src >= (int)sockets.size() || sockets[src] < 0 ) {
+		return 0;
+	}
+	if ( !fits(size, par->MAX_MSG_SIZE) ) {
+		stats.countOversize(src);
+		return 0;
+	}
+	if ( dst < 0 || (par->dropmsg && sendmsg < (int) (par->MSG_DROP_PROB * 100)) ) {
+		return 0;
+	}
+
+	UdpOut out;
+	out.to = addressOf(dst);
+	out.payload = payload;
+	payload->retain();
+	if ( outgoing[src].empty() ) {
+		senders.push_back(src);
+	}
+	outgoing[src].push_back(out);
+
+	stats.countSent(src, par->getcurrtime(), size);
+	if ( log != NULL ) {
+		log->logEvent(EV_SEND, myaddr, toaddr, size);
+	}
+	return size;
+}
+
+/**
+ * FUNCTION NAME: ENsendMulti
+ *
+ * DESCRIPTION: Queue payload for each of the count addresses in toaddrs, all going out
+ * 				in the sender's next sendmmsg. Drops are decided in one pass and the
+ * 				datagrams kept share one retain and one update of the counters.
+ *
+ * RETURNS:
+ * number of messages not dropped
+ */
+int UdpNet::ENsendMulti(Address *myaddr, Address *toaddrs, int count, Payload *payload) {
+	int src = *(int *)(myaddr->addr);
+	int size = payload->getSize();
+
+	if ( src < 0 || src >= (int)sockets.size() || sockets[src] < 0 || !fits(size, par->MAX_MSG_SIZE) ) {
+		// the drop rolls are made all the same, as ENsend would
+		for ( int i = 0; i < count; i++ ) {
+			random.below(100);
+		}
+		if ( src >= 0 && src < (int)sockets.size() && sockets[src] >= 0 ) {
+			stats.countOversize(src, count);
+		}
+		return 0;
+	}
+
+	vector<UdpOut> &out = outgoing[src];
+	bool wasEmpty = out.empty();
+	int sent = 0;
+	for ( int i = 0; i < count; i++ ) {
+		int sendmsg = random.below(100);
+		int dst = *(int *)(toaddrs[i].addr);
+		if ( dst < 0 || (par->dropmsg && sendmsg < (int) (par->MSG_DROP_PROB * 100)) ) {
+			continue;
+		}
+
+		UdpOut o;
+		o.to = addressOf(dst);
+		o.payload = payload;
+		out.push_back(o);
+		if ( log != NULL ) {
+			log->logEvent(EV_SEND, myaddr, &toaddrs[i], size);
+		}
+		sent++;
+	}
+
+	if ( sent > 0 ) {
+		if ( wasEmpty ) {
+			senders.push_back(src);
+		}
+		payload->retain(sent);
+		stats.countSent(src, par->getcurrtime(), size, sent);
+	}
+	return sent;
+}
+
+/**
+ * FUNCTION NAME: flushNode
+ *
+ * DESCRIPTION: Send the queued datagrams of node id, UDP_BATCH per system call.
+ * 				Whatever the socket does not take is lost, as on a real network.
+ */
+void UdpNet::flushNode(int id) {
+	vector<UdpOut> &out = outgoing[id];
+
+	for ( size_t first = 0; first < out.size(); first += UDP_BATCH ) {
+		int n = min((size_t)UDP_BATCH, out.size() - first);
+		for ( int i = 0; i < n; i++ ) {
+			UdpOut *o = &out[first + i];
+			iovs[i].iov_base = o->payload->getData();
+			iovs[i].iov_len = o->payload->getSize();
+			memset(&msgs[i], 0, sizeof(struct mmsghdr));
+			msgs[i].msg_hdr.msg_name = &o->to;
+			msgs[i].msg_hdr.msg_namelen = sizeof(o->to);
+			msgs[i].msg_hdr.msg_iov = &iovs[i];
+			msgs[i].msg_hdr.msg_iovlen = 1;
+		}
+		int sent = 0;
+		while ( sent < n ) {
+			int ret = sendmmsg(sockets[id], &msgs[sent], n - sent, 0);
+			if ( ret <= 0 ) {
+				if ( ret < 0 && errno == EINTR ) {
+					continue;
+				}
+				break;
+			}
+			sent += ret;
+		}
+	}
+
+	for ( size_t i = 0; i < out.size(); i++ ) {
+		out[i].payload->release();
+	}
+	out.clear();
+}
+
+/**
+ * FUNCTION NAME: ENflush
+ *
+ * DESCRIPTION: Send everything queued during the tick
+ */
+void UdpNet::ENflush() {
+	for ( size_t i = 0; i < senders.size(); i++ ) {
+		flushNode(senders[i]);
+	}
+	senders.clear();
+}
+
+/**
+ * FUNCTION NAME: poll
+ *
+ * DESCRIPTION: Mark the sockets that have datagrams waiting
+ */
+void UdpNet::poll() {
+	int n = epoll_wait(epfd, &events[0], events.size(), 0);
+	for ( int i = 0; i < n; i++ ) {
+		readable[events[i].data.u32] = 1;
+	}
+}
+
+/**
+ * FUNCTION NAME: ENrecv
+ *
+ * DESCRIPTION: Hand every datagram waiting for myaddr to enq. As with EmulNet, the
+ * 				receiver releases each buffer with Payload::fromData(buffer)->release().
+ *
+ * RETURN:
+ * 0
+ */
+int UdpNet::ENrecv(Address *myaddr, int (* enq)(void *, char *, int), struct timeval *t, int times, void *queue) {
+	int id = *(int *)(myaddr->addr);
+	if ( id < 0 || id >= (int)sockets.size() || sockets[id] < 0 ) {
+		return 0;
+	}
+
+	// one epoll_wait per tick finds every socket worth a recvmmsg
+	if ( polledAt != par->getcurrtime() ) {
+		poll();
+		polledAt = par->getcurrtime();
+	}
+	if ( !readable[id] ) {
+		return 0;
+	}
+	readable[id] = 0;
+
+	int n;
+	do {
+		for ( int i = 0; i < UDP_BATCH; i++ ) {
+			iovs[i].iov_base = &buffers[i * UDP_BUFFER];
+			iovs[i].iov_len = UDP_BUFFER;
+			memset(&msgs[i], 0, sizeof(struct mmsghdr));
+			msgs[i].msg_hdr.msg_name = &names[i];
+			msgs[i].msg_hdr.msg_namelen = sizeof(names[i]);
+			msgs[i].msg_hdr.msg_iov = &iovs[i];
+			msgs[i].msg_hdr.msg_iovlen = 1;
+		}
+		n = recvmmsg(sockets[id], &msgs[0], UDP_BATCH, MSG_DONTWAIT, NULL);
+		for ( int i = 0; i < n; i++ ) {
+			int size = msgs[i].msg_len;
+			Payload *payload = Payload::create(&buffers[i * UDP_BUFFER], size);
+			(*enq)(queue, payload->getData(), size);
+			stats.countRecv(id, par->getcurrtime(), size);
+			if ( log != NULL ) {
+				Address from;
+				from.init();
+				*(int *)(from.addr) = ntohs(names[i].sin_port) - par->PORTNUM;
+				log->logEvent(EV_RECV, myaddr, &from, size);
+			}
+		}
+	} while ( n == UDP_BATCH );
+
+	return 0;
+}
+
+/**
+ * FUNCTION NAME: ENsetLog
+ *
+ * DESCRIPTION: Record sends and receives in the event log of log
+ */
+void UdpNet::ENsetLog(Log *log) {
+	this->log = log;
+}
+
+/**
+ * FUNCTION NAME: ENcleanup
+ *
+ * DESCRIPTION: Drop queued datagrams and write msgcount.log. Called exactly once at the
+ * 				end of the program.
+ */
+int UdpNet::ENcleanup() {
+	for ( size_t i = 0; i < senders.size(); i++ ) {
+		vector<UdpOut> &out = outgoing[senders[i]];
+		for ( size_t j = 0; j < out.size(); j++ ) {
+			out[j].payload->release();
+		}
+		out.clear();
+	}
+	senders.clear();
+
+	FILE* file = fopen("msgcount.log", "w+");
+	stats.write(file, par->EN_GPSZ, par->getcurrtime(), par->FIRST_NODE_ID);
+	fclose(file);
+	return 0;
+}
@@ -0,0 +1,88 @@
+/**********************************
+ * FILE NAME: UdpNet.h
+ *
+ * DESCRIPTION: Header file of the UDP transport
+ **********************************/
+
+#ifndef _UDPNET_H_
+#define _UDPNET_H_
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include "stdincludes.h"
+#include "Params.h"
+#include "Member.h"
+#include "Payload.h"
+#include "NetStats.h"
+#include "Random.h"
+#include "Log.h"
+#include "Transport.h"
+
+/*
+ * Macros
+ */
+// Datagrams moved per sendmmsg/recvmmsg call
+#define UDP_BATCH 64
+// Receive buffer per datagram, enough for Params::MAX_MSG_SIZE
+#define UDP_BUFFER 4096
+// Kernel receive buffer asked for each socket
+#define UDP_RCVBUF (1 << 20)
+
+/**
+ * STRUCT NAME: UdpOut
+ *
+ * DESCRIPTION: Datagram waiting for the next sendmmsg of its sender
+ */
+typedef struct UdpOut {
+	struct sockaddr_in to;
+	Payload *payload;
+}UdpOut;
+
+/**
+ * CLASS NAME: UdpNet
+ *
+ * DESCRIPTION: Transport over non-blocking UDP sockets on 127.0.0.1. The node with id i
+ * 				is bound to port PORTNUM + i. Sends are batched per node and go out
+ * 				with sendmmsg at the end of the tick; readable sockets are found with
+ * 				one epoll_wait per tick and drained with recvmmsg. Message drops are
+ * 				emulated as in EmulNet.
+ */
+class UdpNet: public Transport {
+private:
+	Params *par;
+	NetStats stats;
+	Random random;
+	Log *log;
+	int nextid;
+	int epfd;
+	// socket of each node id, -1 if the id is not hosted here
+	vector<int> sockets;
+	// set by epoll_wait, cleared once the socket is drained
+	vector<char> readable;
+	int polledAt;
+	vector< vector<UdpOut> > outgoing;
+	// ids with datagrams in outgoing, in the order they first sent
+	vector<int> senders;
+	vector<char> buffers;
+	vector<struct mmsghdr> msgs;
+	vector<struct iovec> iovs;
+	vector<struct sockaddr_in> names;
+	vector<struct epoll_event> events;
+	struct sockaddr_in addressOf(int id);
+	void poll();
+	void flushNode(int id);
+public:
+	UdpNet(Params *p);
+	virtual ~UdpNet();
+	void *ENinit(Address *myaddr, short port);
+	using Transport::ENsend;
+	int ENsend(Address *myaddr, Address *toaddr, Payload *payload);
+	int ENsendMulti(Address *myaddr, Address *toaddrs, int count, Payload *payload);
+	int ENrecv(Address *myaddr, int (* enq)(void *, char *, int), struct timeval *t, int times, void *queue);
+	void ENflush();
+	void ENsetLog(Log *log);
+	int ENcleanup();
+};
+
+#endif /* _UDPNET_H_ */
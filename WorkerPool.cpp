@@ -0,0 +1,82 @@
+/**********************************
+ * FILE NAME: WorkerPool.cpp
+ *
+ * DESCRIPTION: Definition of the worker pool running the simulation in parallel
+ **********************************/
+
+#include "WorkerPool.h"
+
+/**
+ * Constructor
+ */
+WorkerPool::WorkerPool(int partitions): generation(0), pending(0), stopping(false) {
+	for ( int i = 1; i < partitions; i++ ) {
+		workers.push_back(thread(&WorkerPool::work, this, i));
+	}
+}
+
+/**
+ * Destructor
+ */
+WorkerPool::~WorkerPool() {
+	{
+		unique_lock<mutex> guard(lock);
+		stopping = true;
+	}
+	start.notify_all();
+	for ( size_t i = 0; i < workers.size(); i++ ) {
+		workers[i].join();
+	}
+}
+
+/**
+ * FUNCTION NAME: run
+ *
+ * DESCRIPTION: Run job on every partition and return once all of them are done
+ */
+void WorkerPool::run(function<void(int)> job) {
+	{
+		unique_lock<mutex> guard(lock);
+		this->job = job;
+		pending = workers.size();
+		generation++;
+	}
+	start.notify_all();
+
+	job(0);
+
+	unique_lock<mutex> guard(lock);
+	while ( pending > 0 ) {
+		done.wait(guard);
+	}
+}
+
+/**
+ * FUNCTION NAME: work
+ *
+ * DESCRIPTION: Body of worker threads
+ */
+void WorkerPool::work(int partition) {
+	unsigned long seen = 0;
+	while ( true ) {
+		function<void(int)> current;
+		{
+			unique_lock<mutex> guard(lock);
+			while ( !stopping && generation == seen ) {
+				start.wait(guard);
+			}
+			if ( stopping ) {
+				return;
+			}
+			seen = generation;
+			current = job;
+		}
+
+		current(partition);
+
+		unique_lock<mutex> guard(lock);
+		if ( --pending == 0 ) {
+			done.notify_one();
+		}
+	}
+}
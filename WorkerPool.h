@@ -0,0 +1,43 @@
+/**********************************
+ * FILE NAME: WorkerPool.h
+ *
+ * DESCRIPTION: Header file of the worker pool running the simulation in parallel
+ **********************************/
+
+#ifndef _WORKERPOOL_H_
+#define _WORKERPOOL_H_
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include "stdincludes.h"
+
+/**
+ * CLASS NAME: WorkerPool
+ *
+ * DESCRIPTION: Fixed set of threads that run one job per partition and meet at a barrier.
+ * 				Partition 0 runs on the calling thread, partition k on worker k.
+ */
+class WorkerPool {
+private:
+	vector<thread> workers;
+	mutex lock;
+	condition_variable start;
+	condition_variable done;
+	function<void(int)> job;
+	// bumped once per run() so workers know a new job is posted
+	unsigned long generation;
+	int pending;
+	bool stopping;
+	void work(int partition);
+public:
+	WorkerPool(int partitions);
+	virtual ~WorkerPool();
+	int getPartitions() {
+		return workers.size() + 1;
+	}
+	void run(function<void(int)> job);
+};
+
+#endif /* _WORKERPOOL_H_ */